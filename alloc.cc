@@ -0,0 +1,159 @@
+#include "alloc.hh"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace happy_cube {
+
+// constant initialized, such that operator new may use them at any time
+static std::atomic<bool> enabled_(false);
+static thread_local Allocations::Phase phase = Allocations::other;
+static thread_local Allocations::Counts counts_{};
+
+Allocations::Scope::Scope(Phase p) noexcept
+	: previous(phase)
+{
+	phase = p;
+}
+
+Allocations::Scope::~Scope() {
+	phase = previous;
+}
+
+void
+Allocations::enable(bool e) noexcept {
+	enabled_.store(e, std::memory_order_relaxed);
+}
+
+bool
+Allocations::enabled() noexcept {
+	return enabled_.load(std::memory_order_relaxed);
+}
+
+const Allocations::Counts&
+Allocations::counts() noexcept {
+	return counts_;
+}
+
+Allocations::Counts
+Allocations::since(const Counts& before) noexcept {
+	Counts r;
+	for (unsigned int p = 0; p < phases; ++p)
+		r[p] = Count{counts_[p].allocations - before[p].allocations,
+			     counts_[p].bytes - before[p].bytes};
+	return r;
+}
+
+const char *
+Allocations::name(Phase p) noexcept {
+	static const char *const names[phases] = {
+		"other", "bricks", "setup", "search", "results",
+	};
+	return names[p];
+}
+
+#ifdef HAPPY_CUBE_ALLOCATIONS
+
+static void *
+allocate(std::size_t n, std::size_t alignment) {
+	if (enabled_.load(std::memory_order_relaxed)) {
+		Allocations::Count& c = counts_[phase];
+		++c.allocations;
+		c.bytes += n;
+	}
+	if (0 == n)
+		n = 1;
+	void *p = alignment <= alignof(std::max_align_t) ? std::malloc(n) :
+		std::aligned_alloc(alignment, (n + alignment - 1) / alignment * alignment);
+	if (nullptr == p)
+		throw std::bad_alloc();
+	return p;
+}
+
+#endif
+
+}
+
+#ifdef HAPPY_CUBE_ALLOCATIONS
+
+using happy_cube::allocate;
+
+void *
+operator new(std::size_t n) {
+	return allocate(n, 0);
+}
+
+void *
+operator new[](std::size_t n) {
+	return allocate(n, 0);
+}
+
+void *
+operator new(std::size_t n, std::align_val_t a) {
+	return allocate(n, static_cast<std::size_t>(a));
+}
+
+void *
+operator new[](std::size_t n, std::align_val_t a) {
+	return allocate(n, static_cast<std::size_t>(a));
+}
+
+void *
+operator new(std::size_t n, const std::nothrow_t&) noexcept {
+	try {
+		return allocate(n, 0);
+	} catch (const std::bad_alloc&) {
+		return nullptr;
+	}
+}
+
+void *
+operator new[](std::size_t n, const std::nothrow_t&) noexcept {
+	try {
+		return allocate(n, 0);
+	} catch (const std::bad_alloc&) {
+		return nullptr;
+	}
+}
+
+void
+operator delete(void *p) noexcept {
+	std::free(p);
+}
+
+void
+operator delete[](void *p) noexcept {
+	std::free(p);
+}
+
+void
+operator delete(void *p, std::size_t) noexcept {
+	std::free(p);
+}
+
+void
+operator delete[](void *p, std::size_t) noexcept {
+	std::free(p);
+}
+
+void
+operator delete(void *p, std::align_val_t) noexcept {
+	std::free(p);
+}
+
+void
+operator delete[](void *p, std::align_val_t) noexcept {
+	std::free(p);
+}
+
+void
+operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+	std::free(p);
+}
+
+void
+operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+	std::free(p);
+}
+
+#endif
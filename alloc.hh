@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace happy_cube {
+
+// The heap allocations of the calling thread by phase of a solve, counted
+// by the global operator new of builds with HAPPY_CUBE_ALLOCATIONS defined
+// (the cmake option of the same name) while counting is enabled.
+class Allocations {
+public:
+	enum Phase {
+		other,
+		// Brick and its orientations
+		bricks,
+		// the structures of a search, before its first node
+		setup,
+		search,
+		// the assemblies handed out
+		results,
+		phases,
+	};
+
+	struct Count {
+		unsigned long allocations, bytes;
+	};
+	typedef std::array<Count, phases> Counts;
+
+	// Makes the allocations of the calling thread count for a phase until
+	// destroyed.
+	class Scope {
+	private:
+		Phase previous;
+
+	public:
+		explicit Scope(Phase) noexcept;
+		Scope(const Scope&) = delete;
+		~Scope();
+	};
+
+	// whether operator new counts
+	static constexpr bool available() noexcept;
+	static void enable(bool) noexcept;
+	static bool enabled() noexcept;
+
+	// the allocations of the calling thread, and those since a snapshot
+	static const Counts& counts() noexcept;
+	static Counts since(const Counts&) noexcept;
+
+	static const char *name(Phase) noexcept;
+};
+
+constexpr bool
+Allocations::available() noexcept {
+#ifdef HAPPY_CUBE_ALLOCATIONS
+	return true;
+#else
+	return false;
+#endif
+}
+
+}
@@ -1,14 +1,15 @@
 #include "assemble.hh"
 #include <algorithm>
 #include <utility>
-#include <list>
 #include <iostream>
-#if !defined(__cpp_impl_three_way_comparison) || __cpp_impl_three_way_comparison < 201907L
-#include "compare.hpp"
-#define ORD GP::impl
-#else
-#define ORD std
-#endif
+#include <array>
+#include <optional>
+#include <cassert>
+#include "alloc.hh"
+#include "symmetry.hh"
+#include "piece.hh"
+#include "unrolled.hh"
+#include "trace.hh"
 
 namespace happy_cube {
 
@@ -17,147 +18,99 @@ typedef std::vector<BrickRef> Bricks;
 
 typedef std::vector<BrickBRef> BrickBs;
 
-class BO {
-private:
-	unsigned int brick_;
-	unsigned int orientation_;
-
-public:
-	BO(unsigned int brick__, unsigned int orientation__) noexcept;
-
-	unsigned int brick() const noexcept;
-	unsigned int orientation() const noexcept;
-
-	bool operator<(const BO& other) const noexcept;
-	bool operator>(const BO& other) const noexcept;
-	bool operator<=(const BO& other) const noexcept;
-	bool operator>=(const BO& other) const noexcept;
-	bool operator==(const BO& other) const noexcept;
-	bool operator!=(const BO& other) const noexcept;
-#if defined(__cpp_impl_three_way_comparison) && __cpp_impl_three_way_comparison >= 201907L
-	std::partial_ordering operator<=>(const BO&) const noexcept;
-#else
-	ORD::partial_ordering cmp(const BO&) const noexcept;
-#endif
-};
-
-inline
-BO::BO(unsigned int brick__, unsigned int orientation__) noexcept
-	: brick_(brick__)
-	, orientation_(orientation__)
-{
-}
-
-inline unsigned int
-BO::brick() const noexcept {
-	return brick_;
-}
-
-inline unsigned int
-BO::orientation() const noexcept {
-	return orientation_;
-}
-
-#if defined(__cpp_impl_three_way_comparison) && __cpp_impl_three_way_comparison >= 201907L
-inline std::partial_ordering
-BO::operator<=>(const BO& other) const noexcept {
-#else
-inline ORD::partial_ordering
-BO::cmp(const BO& other) const noexcept {
-#endif
-	if (brick() < other.brick())
-		return ORD::partial_ordering::less;
-	if (brick() > other.brick())
-		return ORD::partial_ordering::greater;
-	if (orientation() < other.orientation())
-		return ORD::partial_ordering::less;
-	return orientation() > other.orientation() ?
-		ORD::partial_ordering::greater : ORD::partial_ordering::equivalent;
-}
-
-inline bool
-BO::operator<(const BO& other) const noexcept {
-#if defined(__cpp_impl_three_way_comparison) && __cpp_impl_three_way_comparison >= 201907L
-	return (*this <=> other) < 0;
-#else
-	return cmp(other) < 0;
-#endif
-}
-
-inline bool
-BO::operator>(const BO& other) const noexcept {
-	return other < *this;
-}
-
-inline bool
-BO::operator<=(const BO& other) const noexcept {
-	return !(other < *this);
-}
-
-inline bool
-BO::operator>=(const BO& other) const noexcept {
-	return !(*this < other);
-}
-
-inline bool
-BO::operator==(const BO& other) const noexcept {
-	return brick() == other.brick() && orientation() == other.orientation();
-}
-
-inline bool
-BO::operator!=(const BO& other) const noexcept {
-	return !(*this == other);
-}
-
-typedef std::list<BO> BOs;
-
+// The reference search, on the ids of table: the candidates of a slot are
+// the ranges of ids of the bricks not placed yet, walked in order.
 class Algorithm {
 private:
 	const Bricks& bricks;
-	std::vector<BO> solution;
-
-	// the brick/orientations that were already tried
-	BOs utop, uright, ubottom, uleft;
-
-	// the brick/orientations that can still be used
-	BOs available;
+	const PieceTable& table;
+	// the ids in table placed, by slot
+	std::vector<unsigned int> solution;
+	// the bricks placed
+	std::vector<char> used;
+
+	// the symmetries of the cube if only one assembly of each class of
+	// equivalent assemblies is to be explored, nullptr otherwise
+	const std::vector<Symmetry> *symmetries;
+	// the index of the first brick equal to each brick
+	std::vector<unsigned int> first;
+	// turned[b][o][n] is the orientation of brick b equal to its
+	// orientation o turned by BrickB::t(n)
+	std::vector<std::array<std::array<unsigned char, 8>, 8> > turned;
+
+	// the events of the search, if traced
+	Trace::Ring *ring;
 
 public:
-	Algorithm(const Bricks&, unsigned int orientation);
+	Algorithm(const Bricks&, const PieceTable&, unsigned int orientation,
+		  bool reduce = false);
 
-	bool assemble();
-	std::vector<BO>&& result() &&;
+	// returns the number of solutions found, stopping at limit
+	unsigned int assemble(unsigned int limit = 1);
+	// calls visit for every solution, the ids in table by slot, until it
+	// returns false; returns the number of solutions visited
+	unsigned int assemble(const std::function<bool(const std::vector<unsigned int>&)>& visit);
 
 private:
-	bool top();
-	bool right();
-	bool bottom();
-	bool left();
-	bool lid();
-
-	bool fits_top(const BO&) const;
-	bool fits_right(const BO&) const;
-	bool fits_bottom(const BO&) const;
-	bool fits_left(const BO&) const;
-	bool fits_lid(const BO&) const;
-
-	const BrickB& brick(const BO&) const noexcept;
-
-	void undo(BOs&);
+	// places every orientation fitting on the next slot in turn and
+	// searches the slots after it; false once visit returns false
+	bool place(const std::function<bool(const std::vector<unsigned int>&)>& visit,
+		   unsigned int& found);
+
+	bool fits(unsigned int slot, unsigned int e) const;
+	bool fits_top(unsigned int e) const;
+	bool fits_right(unsigned int e) const;
+	bool fits_bottom(unsigned int e) const;
+	bool fits_left(unsigned int e) const;
+	bool fits_lid(unsigned int e) const;
+
+	bool leads(unsigned int e) const;
+	// whether e, fitting or not, is placed on slot, traced
+	bool accepts(unsigned int slot, unsigned int e, bool fits) const;
+	Trace::Reason why(unsigned int slot, unsigned int e) const;
 };
 
-Algorithm::Algorithm(const Bricks& bricks__, unsigned int orientation)
+static const std::vector<Symmetry>&
+cube_symmetries() {
+	static const std::vector<Symmetry> s(symmetries(Surface::cube()));
+	return s;
+}
+
+Algorithm::Algorithm(const Bricks& bricks__, const PieceTable& table__,
+		     unsigned int orientation, bool reduce)
 	: bricks(bricks__)
+	, table(table__)
+	, used(bricks.size(), 0)
+	, symmetries(reduce ? &cube_symmetries() : nullptr)
+	, ring(Trace::ring())
 {
-	solution.emplace_back(0, orientation);
-	for (unsigned int i = 1; i < bricks.size(); ++i)
-		for (unsigned int j = 0; j < bricks[i].get().degree(); ++j)
-			available.emplace_back(i, j);
+	solution.push_back(table.id(0, orientation));
+	used[0] = 1;
+
+	if (!reduce)
+		return;
+
+	// the bricks are sorted, equal bricks are adjacent and have their
+	// orientations in the same order
+	first.reserve(bricks.size());
+	turned.resize(bricks.size());
+	for (unsigned int i = 0; i < bricks.size(); ++i) {
+		const Brick& b = bricks[i];
+		first.push_back(i > 0 && b == bricks[i - 1].get() ? first[i - 1] : i);
+		for (unsigned int o = 0; o < b.degree(); ++o)
+			for (unsigned int n = 0; n < 8; ++n) {
+				std::uint16_t c = BrickB::transform(b.brick(o).code(), n);
+				unsigned int k = 0;
+				while (b.brick(k).code() != c)
+					++k;
+				turned[i][o][n] = k;
+			}
+	}
 }
 
-Solution
-Solution::assemble(const Brick& b1, const Brick& b2, const Brick& b3,
-		   const Brick& b4, const Brick& b5, const Brick& b6) {
+static Bricks
+sort(const Brick& b1, const Brick& b2, const Brick& b3,
+     const Brick& b4, const Brick& b5, const Brick& b6) {
 	Bricks bricks;
 	bricks.reserve(6);
 	bricks.push_back(std::cref(b1));
@@ -170,300 +123,387 @@ Solution::assemble(const Brick& b1, const Brick& b2, const Brick& b3,
 		  [](const Brick& b1, const Brick& b2) {
 			  return b1 < b2;
 		  });
+	return bricks;
+}
+
+Solution
+Solution::assemble(const Brick& b1, const Brick& b2, const Brick& b3,
+		   const Brick& b4, const Brick& b5, const Brick& b6) {
+	return first(b1, b2, b3, b4, b5, b6, nullptr, branches);
+}
 
-	Algorithm alg(bricks, 0);
-	if (alg.assemble()) {
-		Solution s;
-		std::vector<BO> solution(std::move(alg).result());
-		for (const BO& e: solution)
-			s.emplace_back(std::cref(bricks[e.brick()].get().brick(e.orientation())));
-		return s;
+// the first assembly of Unrolled, in all the top level branches if b is
+// branches, and, given a control, its allocations and times by phase in
+// its stats
+Solution
+Solution::first(const Brick& b1, const Brick& b2, const Brick& b3,
+		const Brick& b4, const Brick& b5, const Brick& b6,
+		Control *control, unsigned int b) {
+	Allocations::Counts before(Allocations::counts());
+	Control::Clock::time_point t0 = Control::Clock::now();
+	std::optional<Allocations::Scope> scope(std::in_place, Allocations::setup);
+	Bricks bricks(sort(b1, b2, b3, b4, b5, b6));
+	PieceTable table(bricks);
+
+	Solution s;
+	std::function<bool(const std::array<Pick, 6>&)> visit =
+		[&s, &bricks](const std::array<Pick, 6>& a) {
+			Allocations::Scope scope(Allocations::results);
+			for (const Pick& e: a)
+				s.emplace_back(std::cref(bricks[e.brick].get().brick(e.orientation)));
+			return false;
+		};
+	Unrolled<cube_layout> u(bricks, table, visit, control);
+	scope.emplace(Allocations::search);
+	Control::Clock::time_point t1 = Control::Clock::now();
+	if (Solution::branches == b)
+		u.run();
+	else
+		u.run(b);
+	scope.reset();
+	if (control) {
+		control->allocated(Allocations::since(before));
+		control->timed(t1 - t0, Control::Clock::now() - t1);
 	}
+	return s;
+}
 
-	return Solution();
+Solution
+Solution::assemble(const Brick& b1, const Brick& b2, const Brick& b3,
+		   const Brick& b4, const Brick& b5, const Brick& b6,
+		   Control& control) {
+	return first(b1, b2, b3, b4, b5, b6, &control, branches);
 }
 
-bool
-Algorithm::assemble() {
-	// available contains all bricks and orientations except
-	// those of the foundation
-	// i.e. 5 bricks and their orientations
-	while (top()) {
-		// available contains all bricks and orientations except
-		// those of the foundation and of the top brick
-		// i.e. 4 bricks and their orientations
-		while (right()) {
-			// available contains all bricks and orientations except
-			// those of the foundation, the top, and the right brick
-			// i.e. 3 bricks and their orientations
-			while (bottom()) {
-				// available contains all bricks and
-				// orientations except those of the foundation,
-				// the top, the right, and the bottom brick
-				// i.e. 2 bricks and their orientations
-				while (left()) {
-					// available contains all bricks and
-					// orientations except those of the
-					// foundation, the top, the right, the
-					// bottom, and the left brick
-					// i.e. 1 brick and its orientations
-					if (lid())
-						return true;
-					undo(uleft);
-					// available contains all bricks and
-					// orientations except those of the
-					// foundation, the top, the right, and
-					// the bottom brick, and except those
-					// brick-orientation pairs already
-					// tried to be placed at left
-				}
-				// available contains all bricks and
-				// orientations except those of the foundation,
-				// the top, the right, and the bottom brick
-				// i.e. 2 bricks and their orientations
-				undo(ubottom);
-				// available contains all bricks and
-				// orientations except those of the
-				// foundation, the top, and the right brick,
-				// and except those brick-orientation pairs
-				// already tried to be placed at the bottom
-			}
-			// available contains all bricks and orientations except
-			// those of the foundation, the top, and the right brick
-			// i.e. 3 bricks and their orientations
-			undo(uright);
-			// available contains all bricks and orientations except
-			// those of the foundation and the top brick, and except
-			// those brick-orientation pairs already tried to be
-			// placed on the right
+Solution
+Solution::assemble(const Brick& b1, const Brick& b2, const Brick& b3,
+		   const Brick& b4, const Brick& b5, const Brick& b6,
+		   Control& control, unsigned int b) {
+	assert(b < branches);
+	return first(b1, b2, b3, b4, b5, b6, &control, b);
+}
+
+// The search of Unrolled on the layout of the cube, with an explicit stack
+// so that it can yield: next[k] is the next orientation, by its id in the
+// piece table, to try on slot k.
+Stream<Solution>
+Solution::stream(const Brick& b1, const Brick& b2, const Brick& b3,
+		 const Brick& b4, const Brick& b5, const Brick& b6) {
+	const Layout<6>& layout = cube_layout;
+	const unsigned int n = 6;
+
+	Bricks bricks(sort(b1, b2, b3, b4, b5, b6));
+	PieceTable table(bricks);
+	std::array<bool, n> same, used;
+	for (unsigned int b = 0; b < n; ++b) {
+		same[b] = b > 0 && bricks[b].get() == bricks[b - 1].get();
+		used[b] = false;
+	}
+
+	std::array<unsigned int, n> id, next, mask, value;
+	std::array<std::uint16_t, n> code;
+	// the cells that the brick on slot k has to have filled, false if
+	// a junction of slot k already has more than one filled cell
+	auto enter = [&layout, &code, &mask, &value](unsigned int k) {
+		mask[k] = value[k] = 0;
+		for (unsigned int i = 0; i < layout.count[k]; ++i) {
+			const Closure& x = layout.closures[k][i];
+			unsigned int filled = 0;
+			for (unsigned int j = 0; j < x.count; ++j)
+				filled += code[x.others[j].slot] >> x.others[j].cell & 1;
+			if (filled > 1)
+				return false;
+			mask[k] |= 1u << x.cell;
+			value[k] |= (0 == filled) << x.cell;
+		}
+		return true;
+	};
+
+	Solution s(std::vector<BrickBRef>(n, std::cref(bricks[0].get().brick(0))));
+	id[0] = table.id(0, 0);
+	code[0] = table.code(id[0]);
+	used[0] = true;
+	unsigned int k = 1;
+	if (!enter(k))
+		co_return;
+	next[k] = table.id(1, 0);
+	for (;;) {
+		unsigned int b = n;
+		for (; next[k] < table.size(); ++next[k]) {
+			unsigned int i = next[k];
+			b = table.brick(i);
+			// equal bricks are placed in the order of their indices
+			if (!used[b] && !(same[b] && !used[b - 1]) &&
+			    (table.code(i) & mask[k]) == value[k])
+				break;
+			b = n;
+		}
+		if (n == b) {
+			if (1 == k)
+				co_return;
+			used[table.brick(id[--k])] = false;
+			continue;
 		}
-		// available contains all bricks and orientations except
-		// those of the foundation and of the top brick
-		// i.e. 4 bricks and their orientations
-		undo(utop);
-		// available contains all bricks and orientations except
-		// those of the foundation and except those brick-orientation
-		// pairs already tried to be placed at the top
+
+		id[k] = next[k]++;
+		code[k] = table.code(id[k]);
+		used[b] = true;
+		if (n - 1 == k) {
+			for (unsigned int j = 0; j < n; ++j)
+				s[layout.face[j]] = std::cref(
+					bricks[table.brick(id[j])].get().brick(table.orientation(id[j])));
+			co_yield s;
+			used[b] = false;
+		} else if (enter(k + 1))
+			next[++k] = table.id(1, 0);
+		else
+			used[b] = false;
 	}
-	return false;
 }
 
-bool
-Algorithm::top() {
-	for (const BO& e: available)
-		if (fits_top(e)) {
-			solution.push_back(e);
-			unsigned int b = e.brick();
-			// all orientations of the chosen brick are not
-			// available any more
-			available.remove_if(
-				[b](const BO& e) {
-					return e.brick() == b;
-				});
-			std::copy_if(utop.begin(), utop.end(),
-				     std::back_inserter(available),
-				     [b](const BO& e) {
-					     return e.brick() != b;
-				     });
-			return true;
-		}
-	available.splice(available.end(), utop, utop.begin(), utop.end());
-	return false;
+unsigned int
+Solution::enumerate(const Brick& b1, const Brick& b2, const Brick& b3,
+		    const Brick& b4, const Brick& b5, const Brick& b6,
+		    const std::function<bool(const Solution&)>& visit) {
+	std::optional<Allocations::Scope> scope(std::in_place, Allocations::setup);
+	Bricks bricks(sort(b1, b2, b3, b4, b5, b6));
+	PieceTable table(bricks);
+
+	Algorithm alg(bricks, table, 0);
+	std::function<bool(const std::vector<unsigned int>&)> v =
+		[&bricks, &table, &visit](const std::vector<unsigned int>& solution) {
+			Solution s;
+			{
+				Allocations::Scope scope(Allocations::results);
+				for (unsigned int e: solution)
+					s.emplace_back(std::cref(bricks[table.brick(e)].get().brick(
+						table.orientation(e))));
+			}
+			return visit(s);
+		};
+	scope.emplace(Allocations::search);
+	return alg.assemble(v);
 }
 
-bool
-Algorithm::right() {
-	for (const BO& e: available)
-		if (fits_right(e)) {
-			solution.push_back(e);
-			unsigned int b = e.brick();
-			// all orientations of the chosen brick are not
-			// available any more
-			available.remove_if(
-				[b](const BO& e) {
-					return e.brick() == b;
-				});
-			std::copy_if(uright.begin(), uright.end(),
-				     std::back_inserter(available),
-				     [b](const BO& e) {
-					     return e.brick() != b;
-				     });
-			return true;
-		}
-	available.splice(available.end(), uright, uright.begin(), uright.end());
-	return false;
+unsigned int
+Solution::count(const Brick& b1, const Brick& b2, const Brick& b3,
+		const Brick& b4, const Brick& b5, const Brick& b6,
+		unsigned int limit) {
+	std::optional<Allocations::Scope> scope(std::in_place, Allocations::setup);
+	Bricks bricks(sort(b1, b2, b3, b4, b5, b6));
+	PieceTable table(bricks);
+
+	Algorithm alg(bricks, table, 0, true);
+	scope.emplace(Allocations::search);
+	return alg.assemble(limit);
 }
 
-bool
-Algorithm::bottom() {
-	for (const BO& e: available)
-		if (fits_bottom(e)) {
-			solution.push_back(e);
-			unsigned int b = e.brick();
-			// all orientations of the chosen brick are not
-			// available any more
-			available.remove_if(
-				[b](const BO& e) {
-					return e.brick() == b;
-				});
-			std::copy_if(ubottom.begin(), ubottom.end(),
-				     std::back_inserter(available),
-				     [b](const BO& e) {
-					     return e.brick() != b;
-				     });
-			return true;
-		}
-	available.splice(available.end(), ubottom, ubottom.begin(), ubottom.end());
-	return false;
+unsigned int
+Algorithm::assemble(unsigned int limit) {
+	unsigned int found = 0;
+	std::function<bool(const std::vector<unsigned int>&)> visit =
+		[&found, limit](const std::vector<unsigned int>&) {
+			return ++found < limit;
+		};
+	assemble(visit);
+	return found;
 }
 
-bool
-Algorithm::left() {
-	for (const BO& e: available)
-		if (fits_left(e)) {
-			solution.push_back(e);
-			unsigned int b = e.brick();
-			// all orientations of the chosen brick are not
-			// available any more
-			available.remove_if(
-				[b](const BO& e) {
-					return e.brick() == b;
-				});
-			std::copy_if(uleft.begin(), uleft.end(),
-				     std::back_inserter(available),
-				     [b](const BO& e) {
-					     return e.brick() != b;
-				     });
-			return true;
-		}
-	available.splice(available.end(), uleft, uleft.begin(), uleft.end());
-	return false;
+unsigned int
+Algorithm::assemble(const std::function<bool(const std::vector<unsigned int>&)>& visit) {
+	unsigned int found = 0;
+	if (ring)
+		ring->push(Trace::event(Trace::search, 0, table.brick(solution[0]),
+					table.orientation(solution[0])));
+	place(visit, found);
+	return found;
 }
 
+// The orientations of the bricks not placed yet are in the ranges of ids of
+// their bricks; the foundation is brick 0.
 bool
-Algorithm::lid() {
-	for (const BO& e: available)
-		if (fits_lid(e)) {
-			solution.push_back(e);
-			unsigned int b = e.brick();
-			// all orientations of the chosen brick are not
-			// available any more
-			available.remove_if(
-				[b](const BO& e) {
-					return e.brick() == b;
-				});
-			assert(available.empty());
-			return true;
+Algorithm::place(const std::function<bool(const std::vector<unsigned int>&)>& visit,
+		 unsigned int& found) {
+	const unsigned int slot = solution.size();
+	for (unsigned int e = table.id(1, 0); e < table.size(); ++e) {
+		unsigned int b = table.brick(e);
+		if (used[b]) {
+			e = table.id(b, 0) + table.degree(b) - 1;
+			continue;
 		}
-	return false;
+		if (!accepts(slot, e, fits(slot, e)))
+			continue;
+		solution.push_back(e);
+		used[b] = 1;
+		if (5 == slot) {
+			if (ring)
+				ring->push(Trace::event(Trace::solution, 5));
+			++found;
+			if (!visit(solution))
+				return false;
+		} else if (!place(visit, found))
+			return false;
+		if (ring)
+			ring->push(Trace::event(Trace::undo, slot));
+		used[b] = 0;
+		solution.pop_back();
+	}
+	return true;
+}
+
+// The checks are made on the codes of the sides: a side of the brick to fit
+// is flipped to face the side of a neighbour, cell 0 of a side is its
+// first corner and cell 4 its last.
+static bool
+corner(unsigned int a, unsigned int b, unsigned int c) noexcept {
+	return Side::corner(0 != a, 0 != b, 0 != c);
 }
 
-void
-Algorithm::undo(BOs& unavailable) {
-	const BO& crt = solution.back();
-	// mark the BO as unavailable
-	unavailable.push_back(crt);
-	// add all orientations of the current brick, except those in the unavailable list,
-	// to the available list
-	for (unsigned int i = 0; i < bricks[crt.brick()].get().degree(); ++i) {
-		auto k = std::find_if(unavailable.begin(), unavailable.end(),
-				      [b = crt.brick(), i](const BO& e) {
-					      return e.brick() == b &&
-						      e.orientation() == i;
-				      });
-		if (unavailable.end() == k)
-			available.emplace_back(crt.brick(), i);
+bool
+Algorithm::fits(unsigned int slot, unsigned int e) const {
+	switch (slot) {
+	case 1:
+		return fits_top(e);
+	case 2:
+		return fits_right(e);
+	case 3:
+		return fits_bottom(e);
+	case 4:
+		return fits_left(e);
+	default:
+		return fits_lid(e);
 	}
-	available.remove_if([&unavailable](const BO& e) {
-		return unavailable.end() != std::find(unavailable.begin(), unavailable.end(), e);
-	});
-	// remove the element from the solution
-	solution.pop_back();
 }
 
 bool
-Algorithm::fits_top(const BO& e) const {
-	const BrickB& foundation = brick(solution[0]);
-	const BrickB& to_fit = brick(e);
-	return foundation.top().match(to_fit.bottom().flip());
+Algorithm::fits_top(unsigned int e) const {
+	return Side::match(table.side(solution[0], 0), Side::flip(table.side(e, 2)));
 }
 
 bool
-Algorithm::fits_right(const BO& e) const {
-	const BrickB& foundation = brick(solution[0]);
-	const BrickB& to_fit = brick(e);
-	if (foundation.right().match(to_fit.bottom().flip())) {
-		const BrickB& t = brick(solution[1]);
-		if (t.right().match(to_fit.left().flip())) {
-			// check that the corner foundation-top-right is filled
-			if (Side::corner(foundation.right()[0], t.right()[4], to_fit.left()[0]))
-				return true;
-		}
-	}
-	return false;
+Algorithm::fits_right(unsigned int e) const {
+	unsigned int f = table.side(solution[0], 1), t = table.side(solution[1], 1);
+	// the corner foundation-top-right is filled
+	return Side::match(f, Side::flip(table.side(e, 2))) &&
+		Side::match(t, Side::flip(table.side(e, 3))) &&
+		corner(f & 1, t & 16, table.side(e, 3) & 1);
 }
 
 bool
-Algorithm::fits_bottom(const BO& e) const {
-	const BrickB& foundation = brick(solution[0]);
-	const BrickB& to_fit = brick(e);
-	if (foundation.bottom().match(to_fit.bottom().flip())) {
-		const BrickB& r = brick(solution[2]);
-		if (r.right().match(to_fit.left().flip())) {
-			// check that the corner foundation-right-bottom is filled
-			if (Side::corner(foundation.bottom()[0], r.right()[4], to_fit.left()[0]))
-				return true;
-		}
-	}
-	return false;
+Algorithm::fits_bottom(unsigned int e) const {
+	unsigned int f = table.side(solution[0], 2), r = table.side(solution[2], 1);
+	// the corner foundation-right-bottom is filled
+	return Side::match(f, Side::flip(table.side(e, 2))) &&
+		Side::match(r, Side::flip(table.side(e, 3))) &&
+		corner(f & 1, r & 16, table.side(e, 3) & 1);
 }
 
 bool
-Algorithm::fits_left(const BO& e) const {
-	const BrickB& foundation = brick(solution[0]);
-	const BrickB& to_fit = brick(e);
-	if (foundation.left().match(to_fit.bottom().flip())) {
-		const BrickB& b = brick(solution[3]);
-		if (b.right().match(to_fit.left().flip())) {
-			// check that the corner foundation-bottom-left is filled
-			if (Side::corner(foundation.left()[0], b.right()[4], to_fit.left()[0])) {
-				const BrickB& t = brick(solution[1]);
-				if (t.left().match(to_fit.right().flip())) {
-					// check that the corner foundation-left-top is filled
-					if (Side::corner(foundation.top()[0], to_fit.right()[4], t.left()[0]))
-						return true;
-				}
-			}
-		}
-	}
-	return false;
+Algorithm::fits_left(unsigned int e) const {
+	unsigned int f = table.side(solution[0], 3), b = table.side(solution[3], 1),
+		t = table.side(solution[1], 3);
+	// the corners foundation-bottom-left and foundation-left-top are
+	// filled
+	return Side::match(f, Side::flip(table.side(e, 2))) &&
+		Side::match(b, Side::flip(table.side(e, 3))) &&
+		corner(f & 1, b & 16, table.side(e, 3) & 1) &&
+		Side::match(t, Side::flip(table.side(e, 1))) &&
+		corner(table.side(solution[0], 0) & 1, table.side(e, 1) & 16, t & 1);
 }
 
 bool
-Algorithm::fits_lid(const BO& e) const {
-	const BrickB& to_fit = brick(e);
-	const BrickB& t = brick(solution[1]);
-	const BrickB& r = brick(solution[2]);
-	const BrickB& b = brick(solution[3]);
-	const BrickB& l = brick(solution[4]);
-	return t.top().match(to_fit.top()) &&
-		r.top().match(to_fit.right()) &&
-		b.top().match(to_fit.bottom()) &&
-		l.top().match(to_fit.left()) &&
-		Side::corner(t.top()[0], l.top()[4], to_fit.top()[0]) &&
-		Side::corner(r.top()[0], t.top()[4], to_fit.right()[0]) &&
-		Side::corner(b.top()[0], r.top()[4], to_fit.bottom()[0]) &&
-		Side::corner(l.top()[0], t.top()[4], to_fit.left()[0]);
+Algorithm::fits_lid(unsigned int e) const {
+	unsigned int t = table.side(solution[1], 0), r = table.side(solution[2], 0),
+		b = table.side(solution[3], 0), l = table.side(solution[4], 0);
+	unsigned int top = table.side(e, 0), right = table.side(e, 1),
+		bottom = table.side(e, 2), left = table.side(e, 3);
+	return Side::match(t, top) && Side::match(r, right) &&
+		Side::match(b, bottom) && Side::match(l, left) &&
+		corner(t & 1, l & 16, top & 1) &&
+		corner(r & 1, t & 16, right & 1) &&
+		corner(b & 1, r & 16, bottom & 1) &&
+		corner(l & 1, b & 16, left & 1);
 }
 
-const BrickB&
-Algorithm::brick(const BO& e) const noexcept {
-	return bricks[e.brick()].get().brick(e.orientation());
+// Tells if the assembly with e placed next can be the least, in the order of
+// the brick classes and orientations on the foundation, top, right, bottom,
+// left, and lid, among the assemblies obtained from it by a symmetry of the
+// cube and by swapping equal bricks. Only the faces that are placed in both
+// are compared, so a partial assembly is cut as soon as a symmetry maps it
+// on a smaller one.
+bool
+Algorithm::leads(unsigned int e) const {
+	if (!symmetries)
+		return true;
+
+	// equal bricks are used in the order of their indices
+	for (unsigned int i = first[table.brick(e)]; i < table.brick(e); ++i)
+		if (!used[i])
+			return false;
+
+	unsigned int d = solution.size();
+	auto at = [this, e, d](unsigned int slot) {
+		return slot < d ? solution[slot] : e;
+	};
+	auto key = [this](unsigned int x, unsigned int n) {
+		unsigned int b = table.brick(x);
+		return first[b] * 8 + turned[b][table.orientation(x)][n];
+	};
+	for (const Symmetry& g: *symmetries)
+		for (unsigned int i = 0; i <= d; ++i) {
+			unsigned int from = g.from[i];
+			if (from > d)
+				// not placed yet
+				break;
+			unsigned int k = key(at(from), g.turn[from]),
+				crt = key(at(i), 0);
+			if (k < crt)
+				return false;
+			if (k > crt)
+				break;
+		}
+	return true;
 }
 
-std::vector<BO>&&
-Algorithm::result() && {
-	return std::move(solution);
+inline bool
+Algorithm::accepts(unsigned int slot, unsigned int e, bool fits) const {
+	bool r = fits && leads(e);
+	if (ring) {
+		unsigned int b = table.brick(e), o = table.orientation(e);
+		ring->push(r ? Trace::event(Trace::place, slot, b, o) :
+			   Trace::event(Trace::reject, slot, b, o,
+					fits ? Trace::symmetry : why(slot, e)));
+	}
+	return r;
+}
+
+// the first junction of e on slot with more than one cell filled, or closed
+// with none: an edge with the brick on another slot, or a corner
+Trace::Reason
+Algorithm::why(unsigned int slot, unsigned int e) const {
+	auto filled = [this, slot, e](const Cell& c) -> unsigned int {
+		return table.code(c.face == slot ? e : solution[c.face]) >> c.cell & 1;
+	};
+	for (const Junction& j: Surface::cube().junctions()) {
+		auto own = std::find_if(j.begin(), j.end(), [slot](const Cell& c) {
+			return c.face == slot;
+		});
+		if (j.end() == own)
+			continue;
+		unsigned int n = 0;
+		bool closed = true;
+		for (const Cell& c: j)
+			if (c.face <= slot)
+				n += filled(c);
+			else
+				closed = false;
+		if (n > 1 || (closed && 0 == n)) {
+			if (j.size() > 2)
+				return Trace::corner;
+			return Trace::Reason(j[0].face == slot ? j[1].face : j[0].face);
+		}
+	}
+	return Trace::other;
 }
 
 }
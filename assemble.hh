@@ -2,7 +2,10 @@
 
 #include <vector>
 #include "brick.hh"
+#include "control.hh"
+#include "stream.hh"
 #include <utility>
+#include <functional>
 
 namespace happy_cube {
 
@@ -23,9 +26,42 @@ public:
 
 	static Solution assemble(const Brick& b1, const Brick& b2, const Brick& b3,
 				 const Brick& b4, const Brick& b5, const Brick& b6);
+	// the same, empty also if control stops the search
+	static Solution assemble(const Brick& b1, const Brick& b2, const Brick& b3,
+				 const Brick& b4, const Brick& b5, const Brick& b6,
+				 Control& control);
+	// the same, searching only the top level branch b < branches: the
+	// brick b + 1, in the order of Brick, on the top
+	static Solution assemble(const Brick& b1, const Brick& b2, const Brick& b3,
+				 const Brick& b4, const Brick& b5, const Brick& b6,
+				 Control& control, unsigned int b);
+	static constexpr unsigned int branches = 5;
+	// All the assemblies, computed as they are pulled, with b1 (in the
+	// order of Brick) on the foundation in its first orientation and
+	// equal bricks in the order of their indices. The bricks have to
+	// outlive the stream.
+	static Stream<Solution> stream(const Brick& b1, const Brick& b2, const Brick& b3,
+				       const Brick& b4, const Brick& b5, const Brick& b6);
+	// Calls visit for every assembly found by the reference search, with
+	// b1 (in the order of Brick) on the foundation in its first
+	// orientation, until visit returns false. Returns the number of
+	// assemblies visited.
+	static unsigned int enumerate(const Brick& b1, const Brick& b2, const Brick& b3,
+				      const Brick& b4, const Brick& b5, const Brick& b6,
+				      const std::function<bool(const Solution&)>& visit);
+	// the number of distinct assemblies, up to limit; assemblies mapped
+	// on one another by a rotation or reflection of the cube or by
+	// swapping equal bricks are counted once
+	static unsigned int count(const Brick& b1, const Brick& b2, const Brick& b3,
+				  const Brick& b4, const Brick& b5, const Brick& b6,
+				  unsigned int limit);
 
 private:
 	Solution(std::vector<BrickBRef>&& v) noexcept;
+
+	static Solution first(const Brick& b1, const Brick& b2, const Brick& b3,
+			      const Brick& b4, const Brick& b5, const Brick& b6,
+			      Control *, unsigned int b);
 };
 
 inline
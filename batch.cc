@@ -0,0 +1,249 @@
+#include "batch.hh"
+#include "control.hh"
+#include "unrolled.hh"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <set>
+#include <thread>
+
+namespace happy_cube {
+
+// the nodes of a probe
+static const unsigned long probe = 4096;
+
+typedef std::vector<std::reference_wrapper<const Brick> > Bricks;
+
+// calls f(i, t) for i < n on threads t
+template<typename F>
+static void
+parallel(std::size_t n, unsigned int threads, F f) {
+	std::atomic<std::size_t> next(0);
+	std::vector<std::thread> workers;
+	workers.reserve(threads);
+	for (unsigned int t = 0; t < threads; ++t)
+		workers.emplace_back([&next, &f, n, t]() {
+			for (std::size_t i = next++; i < n; i = next++)
+				f(i, t);
+		});
+	for (std::thread& t: workers)
+		t.join();
+}
+
+// by slot of the cube after the first, the slots before it it shares an
+// edge with
+static const std::array<unsigned int, 6>&
+neighbours() {
+	static const std::array<unsigned int, 6> r = [] {
+		std::array<unsigned int, 6> r{};
+		for (unsigned int k = 0; k < r.size(); ++k) {
+			std::set<unsigned int> slots;
+			for (unsigned int i = 0; i < cube_layout.count[k]; ++i) {
+				const Closure& x = cube_layout.closures[k][i];
+				if (0 != x.cell % 4)
+					for (unsigned int j = 0; j < x.count; ++j)
+						slots.insert(x.others[j].slot);
+			}
+			r[k] = slots.size();
+		}
+		return r;
+	}();
+	return r;
+}
+
+// Slot k is tried with each of the 6 - k bricks left in each of its
+// orientations, and a brick fits each of the neighbours placed with the
+// share of sides of the set matching.
+static double
+prior(const Bricks& bricks) {
+	double degree = 0;
+	unsigned long tried = 0, matching = 0;
+	for (unsigned int i = 0; i < bricks.size(); ++i) {
+		const Brick& a = bricks[i];
+		degree += a.degree();
+		for (unsigned int j = 0; j < bricks.size(); ++j) {
+			if (i == j)
+				continue;
+			const Brick& b = bricks[j];
+			for (unsigned int n = 0; n < 4; ++n)
+				for (unsigned int o = 0; o < b.degree(); ++o) {
+					++tried;
+					matching += Side::match(BrickB::side(a.code(), n),
+								Side::flip(BrickB::side(b.brick(o).code(), 0)));
+				}
+		}
+	}
+	degree /= bricks.size();
+	double density = double(matching) / tried;
+
+	double r = 1, level = 1;
+	for (unsigned int k = 1; k < bricks.size(); ++k) {
+		level *= (bricks.size() - k) * degree * std::pow(density, neighbours()[k]);
+		r += level;
+	}
+	return r;
+}
+
+namespace {
+
+// The times and nodes of all the searches of a puzzle, the probe, the
+// search again and the top level branches, recorded once its assembly is
+// final, such that a puzzle makes one sample however it is searched.
+struct Tally {
+	std::atomic<Control::Clock::rep> setup, search;
+	std::atomic<unsigned long> nodes;
+	// the searches of the puzzle still running
+	std::atomic<unsigned int> left;
+
+	void add(const Control&) noexcept;
+	// the last search of the puzzle ended
+	bool end() noexcept;
+	void record(Metrics::Recorder *, bool found) const noexcept;
+};
+
+inline void
+Tally::add(const Control& control) noexcept {
+	const Control::Stats& s = control.stats();
+	setup.fetch_add(s.setup.count(), std::memory_order_relaxed);
+	search.fetch_add(s.search.count(), std::memory_order_relaxed);
+	nodes.fetch_add(s.nodes, std::memory_order_relaxed);
+}
+
+inline bool
+Tally::end() noexcept {
+	return 1 == left.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void
+Tally::record(Metrics::Recorder *r, bool found) const noexcept {
+	if (!r)
+		return;
+	r->record(Metrics::setup, Control::Clock::duration(setup.load(std::memory_order_relaxed)));
+	r->record(Metrics::search, Control::Clock::duration(search.load(std::memory_order_relaxed)));
+	r->count(1, found, nodes.load(std::memory_order_relaxed));
+}
+
+}
+
+static Cost
+estimate(const Puzzle& p, unsigned long probe, Tally *tally) {
+	Bricks b(p.bricks());
+	Control control;
+	control.limited(probe);
+	Cost r{0, false, Solution::assemble(b[0], b[1], b[2], b[3], b[4], b[5], control)};
+	const Control::Stats& s = control.stats();
+	r.solved = Control::complete == control.status();
+	if (tally)
+		tally->add(control);
+	if (r.solved)
+		r.nodes = s.nodes;
+	else if (s.done > 0)
+		r.nodes = s.nodes / s.done;
+	else
+		r.nodes = std::max<double>(s.nodes, prior(b));
+	return r;
+}
+
+Cost
+estimate(const Puzzle& p, unsigned long probe) {
+	return estimate(p, probe, nullptr);
+}
+
+namespace {
+
+// puzzles first to last of an order, or one top level branch of a puzzle
+struct Task {
+	std::size_t first, last;
+	unsigned int branch;
+	double cost;
+};
+
+}
+
+std::vector<Solution>
+solve(const std::vector<Puzzle>& puzzles, unsigned int threads, Metrics *metrics) {
+	// without a thread no puzzle would be solved
+	threads = std::max(1u, threads);
+	std::vector<Metrics::Recorder *> recorders(threads, nullptr);
+	if (metrics)
+		for (Metrics::Recorder *& t: recorders)
+			t = &metrics->recorder();
+
+	std::vector<Solution> r(puzzles.size());
+	std::vector<double> cost(puzzles.size());
+	std::unique_ptr<Tally[]> tallies(new Tally[puzzles.size()]());
+	parallel(puzzles.size(), threads, [&](std::size_t i, unsigned int t) {
+		Cost c = estimate(puzzles[i], probe, &tallies[i]);
+		cost[i] = c.solved ? 0 : c.nodes;
+		r[i] = std::move(c.solution);
+		if (c.solved)
+			tallies[i].record(recorders[t], !r[i].empty());
+	});
+
+	std::vector<std::size_t> order;
+	double total = 0;
+	for (std::size_t i = 0; i < puzzles.size(); ++i)
+		if (cost[i] > 0) {
+			order.push_back(i);
+			total += cost[i];
+		}
+	std::sort(order.begin(), order.end(), [&cost](std::size_t i, std::size_t j) {
+		return cost[i] > cost[j];
+	});
+
+	// split the puzzles above half the work of a thread, pack the ones
+	// below a sixty-fourth of it
+	const double split = total / threads / 2, pack = total / threads / 64;
+	std::vector<Task> tasks;
+	for (std::size_t k = 0; k < order.size();) {
+		double c = cost[order[k]];
+		if (c > split) {
+			for (unsigned int b = 0; b < Solution::branches; ++b)
+				tasks.push_back(Task{k, k + 1, b, c / Solution::branches});
+			tallies[order[k]].left.store(Solution::branches, std::memory_order_relaxed);
+			++k;
+			continue;
+		}
+		Task t{k, k, Solution::branches, 0};
+		do {
+			tallies[order[t.last]].left.store(1, std::memory_order_relaxed);
+			t.cost += cost[order[t.last++]];
+		} while (t.cost < pack && t.last < order.size());
+		tasks.push_back(t);
+		k = t.last;
+	}
+	std::stable_sort(tasks.begin(), tasks.end(), [](const Task& a, const Task& b) {
+		return a.cost > b.cost;
+	});
+
+	// the branches of a puzzle stop once one of them finds an assembly
+	std::unique_ptr<std::atomic<bool>[]> found(new std::atomic<bool>[order.size()]());
+	parallel(tasks.size(), threads, [&](std::size_t i, unsigned int thread) {
+		const Task& t = tasks[i];
+		for (std::size_t k = t.first; k < t.last; ++k) {
+			Bricks b(puzzles[order[k]].bricks());
+			Tally& tally = tallies[order[k]];
+			Control control;
+			if (Solution::branches == t.branch)
+				r[order[k]] = Solution::assemble(b[0], b[1], b[2], b[3], b[4], b[5],
+								 control);
+			else {
+				control.cancellable(found[k]);
+				Solution s = Solution::assemble(b[0], b[1], b[2], b[3], b[4], b[5],
+								control, t.branch);
+				if (!s.empty() && !found[k].exchange(true))
+					r[order[k]] = std::move(s);
+			}
+			tally.add(control);
+			// the assembly of the first branch finding one is visible
+			// to the last one ending
+			if (tally.end())
+				tally.record(recorders[thread], !r[order[k]].empty());
+		}
+	});
+
+	return r;
+}
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include "assemble.hh"
+#include "puzzle.hh"
+#include "metrics.hh"
+
+namespace happy_cube {
+
+// The expected cost of Solution::assemble on a puzzle, in search nodes,
+// from a probe search of a few nodes: the nodes of the probe if it runs to
+// its end, else the nodes of the probe divided by the share of the top level
+// branches it completed, or, if it completed none, the nodes expected from
+// the degrees of the bricks and the density of the sides matching.
+struct Cost {
+	double nodes;
+	// the probe ran to its end, with this assembly if there is one
+	bool solved;
+	Solution solution;
+};
+
+extern Cost estimate(const Puzzle&, unsigned long probe);
+
+// The first assembly of every puzzle, empty if there is none, found by
+// several threads, at least one. The puzzles are estimated first, which
+// solves the cheap ones, and the others are dispatched by decreasing cost; a
+// puzzle costing a large share of the work is split into its top level
+// branches, searched in parallel, and the puzzles costing little are packed
+// into batches.
+// Every thread records the setup and the search of its solves in its own
+// recorder of metrics, if given.
+extern std::vector<Solution> solve(const std::vector<Puzzle>&, unsigned int threads,
+				   Metrics * = nullptr);
+
+}
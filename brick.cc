@@ -1,4 +1,5 @@
 #include "brick.hh"
+#include "alloc.hh"
 #include <set>
 
 namespace happy_cube {
@@ -29,6 +30,7 @@ Side::flip() const noexcept {
 }
 
 BrickB::BrickB(const std::vector<unsigned int>& v) {
+	Allocations::Scope scope(Allocations::bricks);
 	std::vector<unsigned int>::const_iterator i = v.begin(), __li = v.end();
 	if (__li != i) {
 		bool last = 0 == *i;
@@ -81,6 +83,7 @@ BrickB::BrickB(const std::vector<unsigned int>& v) {
 
 std::vector<BrickB>
 Brick::variants(bool& flipping) const {
+	Allocations::Scope scope(Allocations::bricks);
 	std::set<BrickB> bricks;
 	auto crt = bricks.insert(*this).first;
 
@@ -4,6 +4,7 @@
 #include <vector>
 #include <ostream>
 #include <cassert>
+#include <cstdint>
 #if !defined(__cpp_impl_three_way_comparison) || __cpp_impl_three_way_comparison < 201907L
 #include "compare.hpp"
 #define ORD GP::impl
@@ -34,6 +35,13 @@ public:
 
 	static bool corner(bool, bool, bool) noexcept;
 
+	// the cells packed in the low 5 bits, cell i in bit i
+	unsigned int code() const noexcept;
+	static Side from_code(unsigned int) noexcept;
+	// flip and match on codes
+	static unsigned int flip(unsigned int) noexcept;
+	static bool match(unsigned int, unsigned int) noexcept;
+
 	bool operator<(const Side&) const noexcept;
 	bool operator>(const Side&) const noexcept;
 	bool operator<=(const Side&) const noexcept;
@@ -77,6 +85,16 @@ public:
 
 	bool valid() const noexcept;
 
+	// the 16 perimeter cells packed clockwise from the top left
+	// corner, i.e. in the numbering of the vector constructor, a set
+	// bit meaning a filled cell
+	std::uint16_t code() const noexcept;
+	static BrickB from_code(std::uint16_t) noexcept;
+	// the code of t(n) computed on the code
+	static std::uint16_t transform(std::uint16_t, unsigned int) noexcept;
+	// the code of a side, 0 top, 1 right, 2 bottom, 3 left
+	static unsigned int side(std::uint16_t, unsigned int) noexcept;
+
 protected:
 	template<typename S1, typename S2, typename S3, typename S4>
 	BrickB(S1&&, S2&&, S3&&, S4&&);
@@ -116,6 +134,12 @@ private:
 	std::vector<BrickB> variants(bool&) const;
 };
 
+// a brick, by its index among several, in one of its orientations
+struct Pick {
+	unsigned int brick;
+	unsigned int orientation;
+};
+
 inline Side&
 Side::operator=(base_type&& v) noexcept {
 	base_type::operator=(std::move(v));
@@ -142,6 +166,28 @@ Side::corner(bool a, bool b, bool c) noexcept {
 	return (!a && (b ^ c)) || (a && !b && !c);
 }
 
+inline unsigned int
+Side::code() const noexcept {
+	return operator[](0) | operator[](1) << 1 | operator[](2) << 2 |
+		operator[](3) << 3 | operator[](4) << 4;
+}
+
+inline Side
+Side::from_code(unsigned int c) noexcept {
+	return Side(base_type{0 != (c & 1), 0 != (c & 2), 0 != (c & 4),
+			      0 != (c & 8), 0 != (c & 16)});
+}
+
+inline unsigned int
+Side::flip(unsigned int c) noexcept {
+	return (c & 1) << 4 | (c & 2) << 2 | (c & 4) | (c & 8) >> 2 | (c & 16) >> 4;
+}
+
+inline bool
+Side::match(unsigned int a, unsigned int b) noexcept {
+	return 0xe == ((a ^ b) & 0xe) && 0 == (a & b & 0x11);
+}
+
 #if defined(__cpp_impl_three_way_comparison) && __cpp_impl_three_way_comparison >= 201907L
 inline std::partial_ordering
 Side::operator<=>(const Side& other) const noexcept {
@@ -354,6 +400,41 @@ BrickB::valid() const noexcept {
 		!(left()[0]   && !left()[1]   && !bottom()[3]);
 }
 
+inline std::uint16_t
+BrickB::code() const noexcept {
+	return top().code() | right().code() << 4 | bottom().code() << 8 |
+		(left().code() & 0xf) << 12;
+}
+
+inline BrickB
+BrickB::from_code(std::uint16_t c) noexcept {
+	return BrickB(Side::from_code(c & 0x1f), Side::from_code(c >> 4 & 0x1f),
+		      Side::from_code(c >> 8 & 0x1f),
+		      Side::from_code((c >> 12 | c << 4) & 0x1f));
+}
+
+inline std::uint16_t
+BrickB::transform(std::uint16_t c, unsigned int n) noexcept {
+	unsigned int r = 4 * n;
+	if (n >= 4) {
+		// reverse the cells, cell c goes to 15 - c, which is a flip
+		// on the line through cells 7 and 8 followed by a rotation
+		c = (c & 0x5555) << 1 | (c >> 1 & 0x5555);
+		c = (c & 0x3333) << 2 | (c >> 2 & 0x3333);
+		c = (c & 0x0f0f) << 4 | (c >> 4 & 0x0f0f);
+		c = c << 8 | c >> 8;
+		r -= 11;
+	}
+	r %= 16;
+	return c << r | c >> (16 - r);
+}
+
+inline unsigned int
+BrickB::side(std::uint16_t c, unsigned int n) noexcept {
+	unsigned int r = 4 * n;
+	return (c >> r | c << (16 - r)) & 0x1f;
+}
+
 template<typename S1, typename S2, typename S3, typename S4>
 inline
 BrickB::BrickB(S1&& top__, S2&& right__, S3&& bottom__, S4&& left__)
@@ -0,0 +1,43 @@
+#include "catalogue.hh"
+#include "combinations.hh"
+#include <set>
+#include <algorithm>
+#include <iterator>
+
+namespace happy_cube {
+
+static std::vector<Brick>
+generate_bricks() {
+	typedef std::set<BrickB> BricksSet;
+	BricksSet aux;
+	for (unsigned int i = 1; i < 16; ++i) {
+		utils::Combinations c(16, i);
+		for (const auto& x: c) {
+			BrickB b(x.elements());
+			if (b.valid()) {
+				BricksSet::iterator e = aux.end();
+				unsigned int k = 0;
+				for (; k < 8; ++k)
+					if (e != aux.find(b.t(k)))
+						break;
+				if (8 == k)
+					aux.emplace(std::move(b));
+			}
+		}
+	}
+
+	typedef std::vector<Brick> Bricks;
+	Bricks bricks;
+	std::move(aux.begin(), aux.end(), std::back_inserter(bricks));
+	std::sort(bricks.begin(), bricks.end());
+
+	return bricks;
+}
+
+const std::vector<Brick>&
+catalogue() {
+	static const std::vector<Brick> bricks(generate_bricks());
+	return bricks;
+}
+
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <vector>
+#include "brick.hh"
+
+namespace happy_cube {
+
+// All valid bricks, one per class of bricks turned or flipped into one
+// another, in the order of Brick. Computed on first use.
+extern const std::vector<Brick>& catalogue();
+
+}
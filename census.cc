@@ -0,0 +1,276 @@
+#include "census.hh"
+#include "assemble.hh"
+#include "combinations.hh"
+#include "intern.hh"
+#include "prefilter.hh"
+#include "puzzle.hh"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace happy_cube {
+
+// the sets between two checks of the clock
+static const std::uint64_t batch = 4096;
+
+bool
+Census::plan(const std::string& dir, const std::vector<std::uint16_t>& codes,
+	     unsigned int shards) {
+	std::uint64_t sets = utils::Combinations::binomial(codes.size(), 6);
+	shards = std::max<std::uint64_t>(1, std::min<std::uint64_t>(shards, sets));
+
+	std::FILE *f = std::fopen((dir + "/manifest").c_str(), "wx");
+	if (nullptr == f)
+		return false;
+	std::ostringstream os;
+	os << "census 1" << std::endl << codes.size() << std::hex;
+	for (std::uint16_t c: codes)
+		os << ' ' << c;
+	os << std::dec << std::endl << shards;
+	for (unsigned int i = 0; i <= shards; ++i)
+		os << ' ' << sets * i / shards;
+	os << std::endl;
+	std::string s(os.str());
+	bool r = s.size() == std::fwrite(s.data(), 1, s.size(), f);
+	return 0 == std::fclose(f) && r;
+}
+
+bool
+Census::open(const std::string& dir__) {
+	std::ifstream is(dir__ + "/manifest");
+	std::string magic;
+	unsigned int version = 0;
+	std::size_t n = 0, shards = 0;
+	if (!(is >> magic >> version >> n) || "census" != magic || 1 != version)
+		return false;
+	codes.resize(n);
+	is >> std::hex;
+	for (std::uint16_t& c: codes)
+		is >> c;
+	is >> std::dec >> shards;
+	bounds.resize(shards + 1);
+	for (std::uint64_t& b: bounds)
+		is >> b;
+	if (!is || 0 == shards || utils::Combinations::binomial(n, 6) != bounds.back())
+		return false;
+	dir = dir__;
+	return true;
+}
+
+std::string
+Census::path(unsigned int shard, const char *kind) const {
+	return dir + "/shard-" + std::to_string(shard) + "." + kind;
+}
+
+bool
+Census::read(const std::string& name, Progress& p) {
+	std::ifstream is(name);
+	return static_cast<bool>(is >> p.next >> p.counts.unsolvable >> p.counts.unique
+				 >> p.counts.multiple >> p.counts.rejected >> p.owner
+				 >> p.length);
+}
+
+// through a temporary file on disk, such that the checkpoint is whole or
+// not there, also after a crash
+bool
+Census::write(const std::string& name, const Progress& p) {
+	std::string tmp = name + "." + std::to_string(getpid());
+	{
+		std::ofstream os(tmp);
+		os << p.next << ' ' << p.counts.unsolvable << ' ' << p.counts.unique
+		   << ' ' << p.counts.multiple << ' ' << p.counts.rejected << ' ' << p.owner
+		   << ' ' << p.length << std::endl;
+		if (!os.flush())
+			return false;
+	}
+	return sync(tmp) && 0 == std::rename(tmp.c_str(), name.c_str());
+}
+
+// writes the data of a file, closed or flushed, to the disk
+bool
+Census::sync(const std::string& name) {
+	int fd = ::open(name.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	bool r = 0 == fsync(fd);
+	return 0 == close(fd) && r;
+}
+
+bool
+Census::claim(unsigned int shard, unsigned int stale, const std::string& token) const {
+	namespace fs = std::filesystem;
+	std::string name = path(shard, "claim");
+	for (unsigned int attempt = 0; attempt < 2; ++attempt) {
+		if (std::FILE *f = std::fopen(name.c_str(), "wx")) {
+			std::fputs(token.c_str(), f);
+			std::fclose(f);
+			return true;
+		}
+		if (0 == stale)
+			return false;
+
+		// taken over if neither the claim nor the checkpoint changed
+		// lately; of the processes renaming the claim only one does
+		std::error_code e;
+		fs::file_time_type t = fs::last_write_time(name, e);
+		if (e)
+			continue;
+		fs::file_time_type k = fs::last_write_time(path(shard, "ckpt"), e);
+		if (!e)
+			t = std::max(t, k);
+		if (fs::file_time_type::clock::now() - t < std::chrono::seconds(stale))
+			return false;
+		std::string old = name + "." + std::to_string(getpid());
+		if (0 != std::rename(name.c_str(), old.c_str()))
+			continue;
+		std::remove(old.c_str());
+	}
+	return false;
+}
+
+// false if another process has taken the shard over
+bool
+Census::owned(unsigned int shard, const std::string& token) const {
+	std::ifstream is(path(shard, "claim"));
+	std::string s;
+	return std::getline(is, s) && s == token;
+}
+
+bool
+Census::run(unsigned int shard, unsigned int interval, const std::string& token) const {
+	namespace fs = std::filesystem;
+	std::string ckpt = path(shard, "ckpt"), sets = path(shard, "sets");
+	std::string mine = sets + "." + token;
+
+	// The puzzles up to the checkpoint are copied out of the file of its
+	// owner, those written after it are found again. Without that file,
+	// e.g. moved into place by an owner that crashed before marking the
+	// shard done, the shard starts over.
+	Progress p{bounds[shard], {0, 0, 0, 0}, token, 0};
+	Progress previous;
+	if (read(ckpt, previous)) {
+		std::string theirs = sets + "." + previous.owner;
+		std::error_code e;
+		if (theirs == mine)
+			fs::resize_file(mine, previous.length, e);
+		else {
+			std::ifstream is(theirs, std::ios::binary);
+			std::ofstream os(mine, std::ios::binary | std::ios::trunc);
+			std::vector<char> buffer(previous.length);
+			if (!is.read(buffer.data(), buffer.size()) ||
+			    !os.write(buffer.data(), buffer.size()))
+				e = std::make_error_code(std::errc::io_error);
+		}
+		if (!e) {
+			p = previous;
+			p.owner = token;
+			if (theirs != mine)
+				std::remove(theirs.c_str());
+		}
+	}
+	std::ofstream out(mine, 0 == p.length ? std::ios::trunc : std::ios::app);
+
+	std::vector<std::reference_wrapper<const Brick> > pool;
+	for (std::uint16_t c: codes)
+		pool.push_back(std::cref(intern(c)));
+
+	auto last = std::chrono::steady_clock::now();
+	const std::uint64_t end = bounds[shard + 1];
+	if (p.next < end) {
+		utils::Combinations combinations(codes.size(), 6, p.next);
+		for (auto i = combinations.begin(); p.next < end; ++i) {
+			const std::vector<unsigned int>& x = (*i).elements();
+			Puzzle s;
+			for (unsigned int k = 0; k < s.size(); ++k)
+				s[k] = codes[x[k]];
+			if (!Prefilter::possible(s)) {
+				++p.counts.unsolvable;
+				++p.counts.rejected;
+			} else if (Solution::assemble(pool[x[0]], pool[x[1]], pool[x[2]],
+						      pool[x[3]], pool[x[4]], pool[x[5]]).empty())
+				++p.counts.unsolvable;
+			else if (1 == Solution::count(pool[x[0]], pool[x[1]], pool[x[2]],
+						      pool[x[3]], pool[x[4]], pool[x[5]], 2)) {
+				++p.counts.unique;
+				out << s << '\n';
+			} else
+				++p.counts.multiple;
+			++p.next;
+
+			if (0 != p.next % batch ||
+			    std::chrono::steady_clock::now() - last < std::chrono::seconds(interval))
+				continue;
+			// the puzzles on disk before the checkpoint refers to
+			// them
+			out.flush();
+			std::error_code e;
+			p.length = fs::file_size(mine, e);
+			if (e || !out || !sync(mine) || !owned(shard, token) || !write(ckpt, p))
+				return false;
+			last = std::chrono::steady_clock::now();
+		}
+	}
+
+	out.close();
+	p.owner = token;
+	std::error_code e;
+	p.length = fs::file_size(mine, e);
+	if (e || !out || !sync(mine) || !owned(shard, token) ||
+	    0 != std::rename(mine.c_str(), sets.c_str()) || !write(ckpt, p) ||
+	    0 != std::rename(ckpt.c_str(), path(shard, "done").c_str()))
+		return false;
+	std::remove(path(shard, "claim").c_str());
+	return true;
+}
+
+unsigned int
+Census::work(unsigned int stale, unsigned int interval) const {
+	char host[256] = "";
+	gethostname(host, sizeof(host) - 1);
+	std::string token = std::string(host) + ":" + std::to_string(getpid());
+
+	unsigned int r = 0;
+	for (unsigned int shard = 0; shard < shards(); ++shard) {
+		if (std::filesystem::exists(path(shard, "done")) ||
+		    !claim(shard, stale, token))
+			continue;
+		// done between the check and the claim
+		if (std::filesystem::exists(path(shard, "done"))) {
+			std::remove(path(shard, "claim").c_str());
+			continue;
+		}
+		if (run(shard, interval, token))
+			++r;
+	}
+	return r;
+}
+
+bool
+Census::merge(std::ostream& os, Counts& total) const {
+	total = Counts{0, 0, 0, 0};
+	for (unsigned int shard = 0; shard < shards(); ++shard) {
+		Progress p;
+		if (!read(path(shard, "done"), p) || bounds[shard + 1] != p.next)
+			return false;
+		total.unsolvable += p.counts.unsolvable;
+		total.unique += p.counts.unique;
+		total.multiple += p.counts.multiple;
+		total.rejected += p.counts.rejected;
+
+		std::ifstream is(path(shard, "sets"), std::ios::binary);
+		if (!is)
+			return false;
+		std::string line;
+		for (std::uint64_t length = 0; length < p.length && std::getline(is, line);
+		     length += line.size() + 1)
+			os << line << '\n';
+	}
+	return static_cast<bool>(os);
+}
+
+}
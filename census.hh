@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+
+namespace happy_cube {
+
+// A search of all the sets of six bricks of a pool for the puzzles they
+// make, shared by processes working in one directory. The sets are split by
+// their rank, in lexicographic order, into the shards of a manifest. A
+// process claims a shard by creating its claim file, writes the puzzles it
+// finds into a file of its own, checkpoints its progress every few seconds,
+// and at its end moves its file into place as the puzzles of the shard and
+// marks the shard done. A shard whose checkpoint is too old is taken over by
+// another process and resumed from that checkpoint, copying the puzzles up
+// to it out of the file of the previous owner, which no longer writes to
+// the files of the shard once it sees that it lost it.
+class Census {
+public:
+	// the unsolvable sets include those rejected by Prefilter
+	struct Counts {
+		std::uint64_t unsolvable, unique, multiple, rejected;
+	};
+
+private:
+	// the progress of a shard: the rank of the next set, and the owner
+	// of the file of puzzles and its length up to that set
+	struct Progress {
+		std::uint64_t next;
+		Counts counts;
+		std::string owner;
+		std::uint64_t length;
+	};
+
+	std::string dir;
+	std::vector<std::uint16_t> codes;
+	// the first rank of every shard, and the number of sets
+	std::vector<std::uint64_t> bounds;
+
+public:
+	// writes the manifest of a new census into an existing directory;
+	// false if there is one already
+	static bool plan(const std::string& dir, const std::vector<std::uint16_t>& codes,
+			 unsigned int shards);
+
+	// reads the manifest; false if it is missing or malformed
+	bool open(const std::string& dir);
+
+	std::size_t shards() const noexcept;
+
+	// Works on the shards not claimed, or claimed and not checkpointed
+	// for stale seconds (if not 0), until none is left, checkpointing
+	// every interval seconds. Returns the number of shards completed.
+	unsigned int work(unsigned int stale, unsigned int interval) const;
+
+	// Writes the uniquely solvable puzzles of all the shards, in the
+	// order of their ranks, and adds up their counts; false if a shard
+	// is not done.
+	bool merge(std::ostream&, Counts&) const;
+
+private:
+	std::string path(unsigned int shard, const char *kind) const;
+
+	bool claim(unsigned int shard, unsigned int stale, const std::string& token) const;
+	bool owned(unsigned int shard, const std::string& token) const;
+	bool run(unsigned int shard, unsigned int interval, const std::string& token) const;
+
+	static bool read(const std::string&, Progress&);
+	static bool write(const std::string&, const Progress&);
+	static bool sync(const std::string&);
+};
+
+inline std::size_t
+Census::shards() const noexcept {
+	return bounds.empty() ? 0 : bounds.size() - 1;
+}
+
+}
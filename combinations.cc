@@ -1,4 +1,5 @@
 #include "combinations.hh"
+#include <algorithm>
 
 namespace utils {
 
@@ -11,6 +12,32 @@ Combinations::state::state(unsigned int n__, unsigned int k__)
 		c.push_back(i);
 }
 
+Combinations::state::state(unsigned int n__, unsigned int k__, std::uint64_t rank)
+	: n((assert(n__ >= k__), n__))
+	, k(k__)
+{
+	assert(rank < binomial(n, k));
+	c.reserve(k);
+	unsigned int x = 0;
+	for (unsigned int i = 0; i < k; ++i, ++x) {
+		// the combinations with x at i and the rest after it
+		for (std::uint64_t m; rank >= (m = binomial(n - 1 - x, k - 1 - i)); ++x)
+			rank -= m;
+		c.push_back(x);
+	}
+}
+
+std::uint64_t
+Combinations::binomial(unsigned int n, unsigned int k) noexcept {
+	if (k > n)
+		return 0;
+	k = std::min(k, n - k);
+	unsigned __int128 r = 1;
+	for (unsigned int i = 0; i < k; ++i)
+		r = r * (n - i) / (i + 1);
+	return r;
+}
+
 bool
 Combinations::state::next() noexcept {
 	for (unsigned int i = k; i > 0;) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
 #include <vector>
 #include <ostream>
 
@@ -27,6 +28,7 @@ private:
 		value_type c;
 
 		state(unsigned int n, unsigned int k);
+		state(unsigned int n, unsigned int k, std::uint64_t rank);
 
 		reference crt() const noexcept;
 		bool next() noexcept;
@@ -64,8 +66,13 @@ public:
 	};
 
 	Combinations(unsigned int n, unsigned int k);
+	// starting at the combination of a rank in lexicographic order
+	Combinations(unsigned int n, unsigned int k, std::uint64_t rank);
 	Combinations(const Combinations&) = delete;
 
+	// the number of combinations, assumed to fit in 64 bits
+	static std::uint64_t binomial(unsigned int n, unsigned int k) noexcept;
+
 	iterator begin() noexcept;
 	iterator end() const noexcept;
 };
@@ -133,6 +140,12 @@ Combinations::Combinations(unsigned int n, unsigned int k)
 {
 }
 
+inline
+Combinations::Combinations(unsigned int n, unsigned int k, std::uint64_t rank)
+	: s(n, k, rank)
+{
+}
+
 inline Combinations::iterator
 Combinations::begin() noexcept {
 	return iterator(s);
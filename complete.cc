@@ -0,0 +1,241 @@
+#include "complete.hh"
+#include "symmetry.hh"
+#include "intern.hh"
+#include <algorithm>
+#include <cassert>
+#include <set>
+
+namespace happy_cube {
+
+namespace {
+
+// a junction narrowed by the brick on a slot: its cell on that brick and
+// the cells on the bricks of earlier slots, Cell::face being the slot
+struct Check {
+	unsigned int cell;
+	std::vector<Cell> others;
+	// the junction has no cell on a free face nor on a later slot
+	bool closed;
+};
+
+// a junction with cells on the free faces: its cells on the slots, and
+// those on the free faces, Cell::face being the index among those
+struct Open {
+	std::vector<Cell> placed;
+	std::vector<Cell> free;
+};
+
+class Completion {
+private:
+	const std::vector<unsigned int>& free;
+	std::set<std::vector<std::uint16_t> >& found;
+
+	std::vector<std::vector<Check> > checks;
+	std::vector<Open> open;
+
+	// the bricks in the order of Brick, and their codes in each
+	// orientation
+	const std::vector<const Brick *>& bricks;
+	std::vector<std::vector<std::uint16_t> > codes;
+
+	std::vector<std::uint16_t> code;
+	std::vector<char> used;
+	std::vector<std::uint16_t> missing;
+
+public:
+	Completion(const Surface&, const std::vector<unsigned int>& free,
+		   const std::vector<const Brick *>&,
+		   std::set<std::vector<std::uint16_t> >& found);
+
+	void run();
+
+private:
+	void place(unsigned int k);
+	void fill(std::size_t j);
+};
+
+// Orders the faces other than the free ones by placing next the face sharing
+// the most junctions with the faces already placed, as Engine does.
+Completion::Completion(const Surface& surface, const std::vector<unsigned int>& free__,
+		       const std::vector<const Brick *>& bricks__,
+		       std::set<std::vector<std::uint16_t> >& found__)
+	: free(free__)
+	, found(found__)
+	, bricks(bricks__)
+	, code(bricks__.size())
+	, used(bricks__.size(), 0)
+	, missing(free__.size())
+{
+	const std::vector<Junction>& junctions = surface.junctions();
+	unsigned int n = surface.faces().size();
+	const unsigned int none = n;
+
+	// the slot of every face, or its index among the free ones past n
+	std::vector<unsigned int> slot(n, none);
+	for (unsigned int i = 0; i < free.size(); ++i)
+		slot[free[i]] = n + 1 + i;
+	auto placed = [&slot, none](const Cell& c) {
+		return slot[c.face] < none;
+	};
+	for (unsigned int k = 0; k < bricks.size(); ++k) {
+		std::vector<unsigned int> shared(n, 0);
+		for (const Junction& j: junctions)
+			if (std::any_of(j.begin(), j.end(), placed))
+				for (const Cell& c: j)
+					++shared[c.face];
+		unsigned int face = none;
+		for (unsigned int f = 0; f < n; ++f)
+			if (none == slot[f] && (none == face || shared[f] > shared[face]))
+				face = f;
+		slot[face] = k;
+
+		checks.emplace_back();
+		for (const Junction& j: junctions) {
+			auto own = std::find_if(j.begin(), j.end(),
+						[face](const Cell& c) {
+							return c.face == face;
+						});
+			if (j.end() == own)
+				continue;
+			Check check{own->cell, {}, true};
+			for (const Cell& c: j)
+				if (c.face != face && placed(c))
+					check.others.push_back(Cell{slot[c.face], c.cell});
+				else if (c.face != face)
+					check.closed = false;
+			if (check.closed || !check.others.empty())
+				checks.back().push_back(std::move(check));
+		}
+	}
+
+	for (const Junction& j: junctions) {
+		Open o;
+		for (const Cell& c: j)
+			if (placed(c))
+				o.placed.push_back(Cell{slot[c.face], c.cell});
+			else
+				o.free.push_back(Cell{slot[c.face] - n - 1, c.cell});
+		if (!o.free.empty())
+			open.push_back(std::move(o));
+	}
+
+	for (const Brick *b: bricks) {
+		codes.emplace_back();
+		for (unsigned int o = 0; o < b->degree(); ++o)
+			codes.back().push_back(b->brick(o).code());
+	}
+}
+
+void
+Completion::run() {
+	place(0);
+}
+
+void
+Completion::place(unsigned int k) {
+	if (bricks.size() == k) {
+		fill(0);
+		return;
+	}
+
+	// the cells of the brick on slot k whose junctions are closed or
+	// already filled: mask, and those that have to be filled: value
+	unsigned int mask = 0, value = 0;
+	for (const Check& c: checks[k]) {
+		unsigned int filled = 0;
+		for (const Cell& e: c.others)
+			filled += code[e.face] >> e.cell & 1;
+		if (filled > 1)
+			return;
+		if (c.closed || 1 == filled)
+			mask |= 1u << c.cell;
+		if (c.closed && 0 == filled)
+			value |= 1u << c.cell;
+	}
+
+	for (unsigned int b = 0; b < bricks.size(); ++b) {
+		// equal bricks are placed in the order of their indices
+		if (used[b] || (b > 0 && !used[b - 1] && *bricks[b] == *bricks[b - 1]))
+			continue;
+		for (std::uint16_t c: codes[b]) {
+			if ((c & mask) != value)
+				continue;
+			code[k] = c;
+			used[b] = 1;
+			place(k + 1);
+			used[b] = 0;
+		}
+	}
+}
+
+// Gives the open junctions from j on that no placed brick fills to one of
+// their free cells, and records the free bricks if they are all valid.
+void
+Completion::fill(std::size_t j) {
+	if (open.size() == j) {
+		std::vector<std::uint16_t> v;
+		for (std::uint16_t c: missing) {
+			if (!BrickB::from_code(c).valid())
+				return;
+			v.push_back(intern(c).brick(0).code());
+		}
+		std::sort(v.begin(), v.end());
+		found.insert(std::move(v));
+		return;
+	}
+
+	const Open& o = open[j];
+	bool filled = std::any_of(o.placed.begin(), o.placed.end(), [this](const Cell& c) {
+		return 0 != (code[c.face] >> c.cell & 1);
+	});
+	if (filled) {
+		fill(j + 1);
+		return;
+	}
+	for (const Cell& c: o.free) {
+		missing[c.face] |= 1u << c.cell;
+		fill(j + 1);
+		missing[c.face] &= ~(1u << c.cell);
+	}
+}
+
+}
+
+std::vector<std::vector<std::uint16_t> >
+complete(const Surface& surface, const std::vector<Brick>& bricks) {
+	unsigned int n = surface.faces().size();
+	assert(bricks.size() < n);
+
+	std::vector<const Brick *> sorted;
+	for (const Brick& b: bricks)
+		sorted.push_back(&b);
+	std::sort(sorted.begin(), sorted.end(), [](const Brick *a, const Brick *b) {
+		return *a < *b;
+	});
+
+	// the sets of free faces, one per class of sets mapped on one
+	// another by symmetries: the least one
+	std::vector<Symmetry> g(symmetries(surface));
+	std::vector<char> chosen(n, 0);
+	std::fill(chosen.end() - (n - bricks.size()), chosen.end(), 1);
+	std::set<std::vector<std::uint16_t> > found;
+	do {
+		std::vector<unsigned int> free;
+		for (unsigned int f = 0; f < n; ++f)
+			if (chosen[f])
+				free.push_back(f);
+		bool least = std::all_of(g.begin(), g.end(), [&free](const Symmetry& s) {
+			std::vector<unsigned int> image;
+			for (unsigned int f: free)
+				image.push_back(s.face[f]);
+			std::sort(image.begin(), image.end());
+			return !(image < free);
+		});
+		if (least)
+			Completion(surface, free, sorted, found).run();
+	} while (std::next_permutation(chosen.begin(), chosen.end()));
+
+	return std::vector<std::vector<std::uint16_t> >(found.begin(), found.end());
+}
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "brick.hh"
+#include "surface.hh"
+
+namespace happy_cube {
+
+// The bricks that complete a set short of one or two bricks on a surface,
+// e.g. five bricks on the cube. The bricks given are assembled on every
+// class of faces left free by symmetries, closing the junctions among
+// them. The free faces then follow from the junctions around them: a cell
+// is filled if no placed brick fills its junction, and the junctions
+// shared by two free faces go to either of them. The free bricks that are
+// valid make a completion. Returns the distinct completions, each as the
+// codes of its bricks in the orientation of the catalogue, sorted.
+extern std::vector<std::vector<std::uint16_t> > complete(const Surface&,
+							 const std::vector<Brick>&);
+
+}
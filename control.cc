@@ -0,0 +1,68 @@
+#include "control.hh"
+#include <algorithm>
+
+namespace happy_cube {
+
+Control::Control() noexcept
+	: deadline(Clock::time_point::max())
+	, budget(~0ul)
+	, cancel(nullptr)
+	, every(0)
+	, stats_{0, 0, {}, {}, {}}
+	, status_(complete)
+	, next(check)
+	, report(~0ul)
+{
+}
+
+Control&
+Control::until(Clock::time_point t) noexcept {
+	deadline = t;
+	return *this;
+}
+
+Control&
+Control::within(Clock::duration d) noexcept {
+	deadline = Clock::now() + d;
+	return *this;
+}
+
+Control&
+Control::limited(unsigned long n) noexcept {
+	budget = n;
+	return *this;
+}
+
+Control&
+Control::cancellable(const std::atomic<bool>& flag) noexcept {
+	cancel = &flag;
+	return *this;
+}
+
+Control&
+Control::reporting(std::function<void(const Stats&)> f, unsigned long n) {
+	progress = std::move(f);
+	every = std::max(n, check);
+	report = stats_.nodes + every;
+	return *this;
+}
+
+bool
+Control::poll() {
+	next = stats_.nodes + check;
+	if (complete != status_)
+		return false;
+	if (cancel && cancel->load(std::memory_order_relaxed))
+		status_ = cancelled;
+	else if (Clock::time_point::max() != deadline && Clock::now() >= deadline)
+		status_ = timeout;
+	else if (stats_.nodes >= budget)
+		status_ = exhausted;
+	if (progress && stats_.nodes >= report) {
+		report = stats_.nodes + every;
+		progress(stats_);
+	}
+	return complete == status_;
+}
+
+}
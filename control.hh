@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include "alloc.hh"
+
+namespace happy_cube {
+
+// The limits of a search, a deadline, a number of nodes and a cancellation
+// flag, and what it reports. The search counts its nodes with node(), which looks at the
+// clock and at the flag only every check nodes, and tells the fraction of
+// its top level branches completed with done().
+class Control {
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	enum Status {
+		// the search ran to its end or its visitor stopped it
+		complete,
+		timeout,
+		cancelled,
+		exhausted,
+	};
+
+	struct Stats {
+		unsigned long nodes;
+		// the fraction of the top level branches completed
+		double done;
+		// by phase, if counted, see Allocations
+		Allocations::Counts allocations;
+		// the time taken to set the search up and by the search
+		Clock::duration setup, search;
+	};
+
+	static constexpr unsigned long check = 1024;
+
+private:
+	Clock::time_point deadline;
+	unsigned long budget;
+	const std::atomic<bool> *cancel;
+	std::function<void(const Stats&)> progress;
+	unsigned long every;
+
+	Stats stats_;
+	Status status_;
+	// the node count of the next check and of the next report
+	unsigned long next, report;
+
+public:
+	Control() noexcept;
+
+	Control& until(Clock::time_point) noexcept;
+	Control& within(Clock::duration) noexcept;
+	// stops at about n nodes
+	Control& limited(unsigned long n) noexcept;
+	Control& cancellable(const std::atomic<bool>&) noexcept;
+	// calls f about every n nodes
+	Control& reporting(std::function<void(const Stats&)> f, unsigned long n);
+
+	// counts a node, false if the search has to stop
+	bool node();
+	void done(double) noexcept;
+	void allocated(const Allocations::Counts&) noexcept;
+	void timed(Clock::duration setup, Clock::duration search) noexcept;
+
+	Status status() const noexcept;
+	const Stats& stats() const noexcept;
+
+private:
+	bool poll();
+};
+
+inline bool
+Control::node() {
+	return ++stats_.nodes < next || poll();
+}
+
+inline void
+Control::done(double d) noexcept {
+	stats_.done = d;
+}
+
+inline void
+Control::allocated(const Allocations::Counts& c) noexcept {
+	for (unsigned int p = 0; p < c.size(); ++p) {
+		stats_.allocations[p].allocations += c[p].allocations;
+		stats_.allocations[p].bytes += c[p].bytes;
+	}
+}
+
+inline void
+Control::timed(Clock::duration setup, Clock::duration search) noexcept {
+	stats_.setup += setup;
+	stats_.search += search;
+}
+
+inline Control::Status
+Control::status() const noexcept {
+	return status_;
+}
+
+inline const Control::Stats&
+Control::stats() const noexcept {
+	return stats_;
+}
+
+}
@@ -0,0 +1,445 @@
+// Runs every engine on random sets of six bricks and compares them with the
+// reference search of Algorithm: whether the set builds a cube and, for
+// the engines that enumerate, the assemblies up to the symmetries of the
+// cube. A set on which they disagree is minimized while they still
+// disagree, see minimize, and printed.
+//
+// differential [<sets> [<threads> [<seed>]]]
+
+#include "assemble.hh"
+#include "catalogue.hh"
+#include "engine.hh"
+#include "generate.hh"
+#include "halves.hh"
+#include "intern.hh"
+#include "lockstep.hh"
+#include "partial.hh"
+#include "piece.hh"
+#include "pool.hh"
+#include "puzzle.hh"
+#include "symmetry.hh"
+#include "unrolled.hh"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <time.h>
+
+using namespace happy_cube;
+
+namespace {
+
+// an assembly by the codes on the faces of Surface::cube()
+typedef std::array<std::uint16_t, 6> Codes;
+typedef std::vector<std::reference_wrapper<const Brick> > Bricks;
+
+struct Result {
+	bool solvable;
+	// the least assembly of each class mapped on one another by the
+	// symmetries of the cube, sorted, if the engine enumerates
+	bool enumerates;
+	std::vector<Codes> classes;
+	// the number of classes, if the engine counts them
+	bool counts;
+	unsigned long count;
+	// the engine filled a cell of a junction twice
+	bool clashes;
+};
+
+bool
+operator==(const Result& a, const Result& b) {
+	return a.solvable == b.solvable && !a.clashes && !b.clashes &&
+		(!a.enumerates || !b.enumerates || a.classes == b.classes) &&
+		(!a.counts || !b.enumerates || a.count == b.classes.size()) &&
+		(!a.enumerates || !b.counts || a.classes.size() == b.count);
+}
+
+// the least of the assemblies a symmetry of the cube maps an assembly on
+Codes
+canonical(const Codes& a) {
+	static const std::vector<Symmetry> g(symmetries(Surface::cube()));
+	Codes r = a;
+	for (const Symmetry& s: g) {
+		Codes m;
+		for (unsigned int i = 0; i < m.size(); ++i)
+			m[i] = BrickB::transform(a[s.from[i]], s.turn[s.from[i]]);
+		r = std::min(r, m);
+	}
+	return r;
+}
+
+class Classes {
+private:
+	std::vector<Codes> v;
+
+public:
+	void add(const Codes& a) {
+		v.push_back(canonical(a));
+	}
+
+	void add(const Solution& s) {
+		Codes a;
+		for (unsigned int i = 0; i < a.size(); ++i)
+			a[i] = s[i].get().code();
+		add(a);
+	}
+
+	void into(Result& r) {
+		std::sort(v.begin(), v.end());
+		v.erase(std::unique(v.begin(), v.end()), v.end());
+		r.solvable = !v.empty();
+		r.enumerates = true;
+		r.classes = std::move(v);
+	}
+};
+
+struct Contender {
+	const char *name;
+	void (*run)(const Bricks&, Result&);
+};
+
+void
+algorithm(const Bricks& b, Result& r) {
+	Classes c;
+	std::function<bool(const Solution&)> visit = [&c](const Solution& s) {
+		c.add(s);
+		return true;
+	};
+	Solution::enumerate(b[0], b[1], b[2], b[3], b[4], b[5], visit);
+	c.into(r);
+}
+
+void
+count(const Bricks& b, Result& r) {
+	r.count = Solution::count(b[0], b[1], b[2], b[3], b[4], b[5], ~0u);
+	r.counts = true;
+	r.solvable = 0 != r.count;
+}
+
+void
+assemble(const Bricks& b, Result& r) {
+	r.solvable = !Solution::assemble(b[0], b[1], b[2], b[3], b[4], b[5]).empty();
+}
+
+void
+stream(const Bricks& b, Result& r) {
+	Classes c;
+	for (const Solution& s: Solution::stream(b[0], b[1], b[2], b[3], b[4], b[5]))
+		c.add(s);
+	c.into(r);
+}
+
+void
+unrolled(const Bricks& b, Result& r) {
+	Bricks sorted(b);
+	std::sort(sorted.begin(), sorted.end(),
+		  [](const Brick& b1, const Brick& b2) {
+			  return b1 < b2;
+		  });
+	PieceTable table(sorted);
+	Classes c;
+	std::function<bool(const std::array<Pick, 6>&)> visit =
+		[&c, &sorted](const std::array<Pick, 6>& a) {
+			Codes k;
+			for (unsigned int i = 0; i < k.size(); ++i)
+				k[i] = sorted[a[i].brick].get().brick(a[i].orientation).code();
+			c.add(k);
+			return true;
+		};
+	Unrolled<cube_layout>(sorted, table, visit).run();
+	c.into(r);
+}
+
+void
+solve(const Engine& e, const Bricks& b, Result& r) {
+	std::vector<Brick> v(b.begin(), b.end());
+	Classes c;
+	std::function<bool(const Assembly&)> visit = [&c, &v](const Assembly& a) {
+		Codes k;
+		for (unsigned int i = 0; i < k.size(); ++i)
+			k[i] = v[a[i].brick].brick(a[i].orientation).code();
+		c.add(k);
+		return true;
+	};
+	e.solve(v, visit);
+	c.into(r);
+}
+
+void
+engine(const Bricks& b, Result& r) {
+	static const Engine e(Surface::cube());
+	solve(e, b, r);
+}
+
+void
+nogoods(const Bricks& b, Result& r) {
+	static const Engine e(Surface::cube(), true);
+	solve(e, b, r);
+}
+
+void
+transpositions(const Bricks& b, Result& r) {
+	static Transpositions t(16);
+	static const Engine e(Surface::cube(), false, &t);
+	solve(e, b, r);
+}
+
+void
+halves(const Bricks& b, Result& r) {
+	static const Halves h;
+	std::vector<Brick> v(b.begin(), b.end());
+	Classes c;
+	std::function<bool(const Assembly&)> visit = [&c, &v](const Assembly& a) {
+		Codes k;
+		for (unsigned int i = 0; i < k.size(); ++i)
+			k[i] = v[a[i].brick].brick(a[i].orientation).code();
+		c.add(k);
+		return true;
+	};
+	h.solve(v, visit);
+	c.into(r);
+}
+
+void
+lockstep(const Bricks& b, Result& r) {
+	std::vector<Puzzle> p(1);
+	for (unsigned int i = 0; i < p[0].size(); ++i)
+		p[0][i] = b[i].get().brick(0).code();
+	std::vector<Cube> cubes;
+	r.solvable = happy_cube::lockstep(p, cubes)[0];
+}
+
+void
+pool(const Bricks& b, Result& r) {
+	Pool p(std::vector<Brick>(b.begin(), b.end()));
+	Cube cube;
+	r.solvable = p.find(cube);
+}
+
+// also checks that the bricks placed fill no cell of a junction twice, as
+// they could if a joint next to an empty face were not checked
+void
+partial(const Bricks& b, Result& r) {
+	Partial p = Partial::assemble(b[0], b[1], b[2], b[3], b[4], b[5], Partial::bricks);
+	r.solvable = p.complete();
+	for (const Junction& j: Surface::cube().junctions()) {
+		unsigned int filled = 0;
+		for (const Cell& c: j)
+			if (const BrickB *f = p.faces()[c.face])
+				filled += f->code() >> c.cell & 1;
+		r.clashes = r.clashes || filled > 1;
+	}
+}
+
+// the processor time of the calling thread, so that the timings do not
+// depend on how many threads share a core
+double
+cpu() noexcept {
+	timespec t;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// the reference first
+const Contender contenders[] = {
+	{"algorithm", algorithm},
+	{"count", count},
+	{"assemble", assemble},
+	{"stream", stream},
+	{"unrolled", unrolled},
+	{"engine", engine},
+	{"nogoods", nogoods},
+	{"table", transpositions},
+	{"halves", halves},
+	{"lockstep", lockstep},
+	{"pool", pool},
+	{"partial", partial},
+};
+const unsigned int n = sizeof(contenders) / sizeof(contenders[0]);
+
+// the engines that disagree with the reference on a set, by index
+unsigned int
+disagree(const Puzzle& p, std::array<double, n> *seconds = nullptr) {
+	Bricks b(p.bricks());
+	Result reference{};
+	unsigned int r = 0;
+	for (unsigned int i = 0; i < n; ++i) {
+		Result x{};
+		double t0 = cpu();
+		contenders[i].run(b, i == 0 ? reference : x);
+		if (seconds)
+			(*seconds)[i] += cpu() - t0;
+		if (i > 0 && !(x == reference))
+			r |= 1u << i;
+	}
+	return r;
+}
+
+// the bricks in the orientations of least code, sorted
+Puzzle
+normalize(Puzzle p) {
+	for (std::uint16_t& c: p) {
+		std::uint16_t least = c;
+		for (unsigned int k = 1; k < 8; ++k)
+			least = std::min(least, BrickB::transform(c, k));
+		c = least;
+	}
+	std::sort(p.begin(), p.end());
+	return p;
+}
+
+bool
+valid(const Puzzle& p) {
+	return std::all_of(p.begin(), p.end(), [](std::uint16_t c) {
+		return BrickB::from_code(c).valid();
+	});
+}
+
+// Makes the set smaller, in the order of the normalized sets, while the
+// same engines disagree: by emptying a cell of a brick, which mostly
+// keeps an unsolvable set unsolvable, or by moving the filled cell of a
+// junction of an assembly to another brick of that junction, which keeps
+// a solvable set solvable.
+Puzzle
+minimize(Puzzle p, unsigned int engines) {
+	p = normalize(p);
+	auto smaller = [&p, engines](Puzzle q) {
+		q = normalize(q);
+		if (!std::lexicographical_compare(q.begin(), q.end(), p.begin(), p.end()) ||
+		    !valid(q) || engines != (disagree(q) & engines))
+			return false;
+		p = q;
+		return true;
+	};
+
+	for (bool again = true; again;) {
+		again = false;
+		for (unsigned int i = 0; i < p.size(); ++i)
+			for (unsigned int c = 0; c < 16; ++c)
+				if (0 != (p[i] >> c & 1)) {
+					Puzzle q = p;
+					q[i] &= ~(1u << c);
+					again = smaller(q) || again;
+				}
+
+		Bricks b(p.bricks());
+		Solution s = Solution::assemble(b[0], b[1], b[2], b[3], b[4], b[5]);
+		if (s.empty())
+			continue;
+		Puzzle a;
+		for (unsigned int f = 0; f < a.size(); ++f)
+			a[f] = s[f].get().code();
+		for (const Junction& j: Surface::cube().junctions())
+			for (const Cell& from: j)
+				for (const Cell& to: j)
+					if (0 != (a[from.face] >> from.cell & 1) &&
+					    from.face != to.face) {
+						Puzzle q = a;
+						q[from.face] &= ~(1u << from.cell);
+						q[to.face] |= 1u << to.cell;
+						again = smaller(q) || again;
+					}
+	}
+	return p;
+}
+
+// a set of six bricks: random valid bricks, bricks of the catalogue in
+// random orientations, or a cut of the cube, in turn
+Puzzle
+draw(std::mt19937_64& rng, Generator& generator, unsigned long k) {
+	Puzzle p;
+	std::uniform_int_distribution<unsigned int> orientation(0, 7);
+	switch (k % 3) {
+	case 0:
+		for (std::uint16_t& c: p)
+			do
+				c = rng();
+			while (!BrickB::from_code(c).valid());
+		break;
+	case 1: {
+		const std::vector<Brick>& all = catalogue();
+		std::uniform_int_distribution<std::size_t> d(0, all.size() - 1);
+		for (std::uint16_t& c: p)
+			c = BrickB::transform(all[d(rng)].code(), orientation(rng));
+		break;
+	}
+	default: {
+		std::vector<std::uint16_t> codes;
+		while (!generator.cut(codes))
+			;
+		std::shuffle(codes.begin(), codes.end(), rng);
+		for (unsigned int i = 0; i < p.size(); ++i)
+			p[i] = BrickB::transform(codes[i], orientation(rng));
+		break;
+	}
+	}
+	return p;
+}
+
+}
+
+int
+main(int argc, char *argv[]) {
+	unsigned long sets = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+	unsigned int threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) :
+		std::max(1u, std::thread::hardware_concurrency());
+	std::uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) :
+		std::random_device()();
+	std::cout << "seed " << seed << std::endl;
+
+	// built up front, not in the timings
+	catalogue();
+	intern(0);
+	Surface::cube();
+
+	std::atomic<unsigned long> next(0), failed(0);
+	std::array<double, n> seconds{};
+	std::mutex mutex;
+	std::vector<std::thread> workers;
+	for (unsigned int t = 0; t < threads; ++t)
+		workers.emplace_back([&, t]() {
+			std::mt19937_64 rng(seed + t);
+			Generator generator(Surface::cube(), rng());
+			std::array<double, n> own{};
+			for (unsigned long k = next++; k < sets; k = next++) {
+				Puzzle p = draw(rng, generator, k);
+				unsigned int engines = disagree(p, &own);
+				if (0 != (k + 1) % 1000000 && 0 == engines)
+					continue;
+
+				std::lock_guard<std::mutex> lock(mutex);
+				if (0 == engines) {
+					std::cerr << k + 1 << " sets" << std::endl;
+					continue;
+				}
+				++failed;
+				std::cout << "mismatch " << p << " minimized "
+					  << minimize(p, engines) << ':';
+				for (unsigned int i = 0; i < n; ++i)
+					if (engines >> i & 1)
+						std::cout << ' ' << contenders[i].name;
+				std::cout << std::endl;
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			for (unsigned int i = 0; i < n; ++i)
+				seconds[i] += own[i];
+		});
+	for (std::thread& w: workers)
+		w.join();
+
+	std::cout << std::setw(10) << "engine" << std::setw(14) << "cpu s"
+		  << std::setw(14) << "us per set" << std::endl;
+	for (unsigned int i = 0; i < n; ++i)
+		std::cout << std::setw(10) << contenders[i].name
+			  << std::setw(14) << seconds[i]
+			  << std::setw(14) << seconds[i] / std::max(sets, 1ul) * 1e6
+			  << std::endl;
+	std::cout << sets << " sets, " << failed << " mismatches" << std::endl;
+
+	return 0 == failed ? 0 : 1;
+}
@@ -0,0 +1,594 @@
+#include "engine.hh"
+#include "symmetry.hh"
+#include "index.hh"
+#include <algorithm>
+#include <cassert>
+#include <random>
+#include <unordered_map>
+
+namespace happy_cube {
+
+Engine::Engine(const Surface& surface__, bool nogoods__, Transpositions *transpositions__)
+	: surface(surface__)
+	, nogoods(nogoods__ && surface__.faces().size() <= 64)
+	, transpositions(transpositions__)
+	, zobrist_cells(surface__.faces().size())
+{
+	std::vector<Symmetry> g(symmetries(surface));
+	for (unsigned int f = 0; f < surface.faces().size(); ++f) {
+		if (g.end() != std::find_if(g.begin(), g.end(),
+					    [f](const Symmetry& s) {
+						    return s.face[f] < f;
+					    }))
+			// f is mapped on an earlier face
+			continue;
+
+		Plan p(plan(f));
+		for (const Symmetry& s: g)
+			if (s.face[f] == f)
+				p.turns.push_back(s.turn[f]);
+		plans.push_back(std::move(p));
+	}
+
+	// the same keys for every engine on the surface, such that they can
+	// share a table
+	std::mt19937_64 rng(surface.faces().size());
+	for (const Junction& j: surface.junctions()) {
+		std::uint64_t z = rng();
+		for (const Cell& c: j)
+			zobrist_cells[c.face][c.cell] = z;
+	}
+	for (unsigned int b = 0; b < surface.faces().size(); ++b)
+		zobrist_bricks.push_back(rng());
+	for (unsigned int p = 0; p < plans.size(); ++p)
+		zobrist_plans.push_back(rng());
+}
+
+// Orders the faces by placing next the face sharing the most junctions with
+// the faces already placed.
+Engine::Plan
+Engine::plan(unsigned int first) const {
+	const std::vector<Junction>& junctions = surface.junctions();
+	unsigned int n = surface.faces().size();
+	const unsigned int none = n;
+
+	std::vector<unsigned int> slot(n, none);
+	Plan p;
+	for (unsigned int face = first; none != face;) {
+		slot[face] = p.slots.size();
+		Slot s{face, {}, 4, {}};
+		for (const Junction& j: junctions) {
+			auto own = std::find_if(j.begin(), j.end(),
+						[face](const Cell& c) {
+							return c.face == face;
+						});
+			if (j.end() == own)
+				continue;
+			Check check{own->cell, {}, 0};
+			for (const Cell& c: j)
+				if (c.face != face && none != slot[c.face]) {
+					check.others.push_back(Cell{slot[c.face], c.cell});
+					check.slots |= std::uint64_t(1) << slot[c.face] % 64;
+				}
+			if (check.others.size() + 1 == j.size())
+				s.checks.push_back(std::move(check));
+		}
+		for (unsigned int side = 0; side < 4 && 4 == s.side; ++side)
+			if (3 == std::count_if(s.checks.begin(), s.checks.end(),
+					       [side](const Check& c) {
+						       return c.cell / 4 == side &&
+							       0 != c.cell % 4;
+					       }))
+				s.side = side;
+		p.slots.push_back(std::move(s));
+
+		std::vector<unsigned int> shared(n, 0);
+		for (const Junction& j: junctions) {
+			bool placed = std::any_of(j.begin(), j.end(),
+						  [&slot, none](const Cell& c) {
+							  return none != slot[c.face];
+						  });
+			if (placed)
+				for (const Cell& c: j)
+					++shared[c.face];
+		}
+		face = none;
+		for (unsigned int f = 0; f < n; ++f)
+			if (none == slot[f] && (none == face || shared[f] > shared[face]))
+				face = f;
+	}
+
+	for (unsigned int k = 0; k < n; ++k)
+		for (const Check& c: p.slots[k].checks)
+			for (const Cell& e: c.others) {
+				std::vector<unsigned int>& a = p.slots[e.face].ahead;
+				if (a.end() == std::find(a.begin(), a.end(), k))
+					a.push_back(k);
+			}
+	return p;
+}
+
+// the bricks in the order of Brick, and their indices in the input
+static std::vector<const Brick *>
+sort(const std::vector<Brick>& bricks, std::vector<unsigned int>& order) {
+	for (unsigned int i = 0; i < bricks.size(); ++i)
+		order.push_back(i);
+	std::sort(order.begin(), order.end(),
+		  [&bricks](unsigned int i, unsigned int j) {
+			  return bricks[i] < bricks[j];
+		  });
+	std::vector<const Brick *> r;
+	for (unsigned int i: order)
+		r.push_back(&bricks[i]);
+	return r;
+}
+
+namespace {
+
+// the bit of slot s, and the bits of the slots before s, in a conflict; the
+// slots past 64 are left out, there are conflicts only with fewer slots
+constexpr std::uint64_t
+bit(unsigned int s) noexcept {
+	return s < 64 ? std::uint64_t(1) << s : 0;
+}
+
+constexpr std::uint64_t
+below(unsigned int s) noexcept {
+	return s < 64 ? (std::uint64_t(1) << s) - 1 : ~std::uint64_t(0);
+}
+
+// Sets of placements, by face, brick and orientation, that no assembly
+// contains, hashed by one of them, the last placed when it was learned.
+class Nogoods {
+private:
+	static constexpr std::size_t capacity = 1 << 22;
+
+	// every nogood as its size and its placements
+	std::vector<std::uint32_t> placements;
+	std::unordered_map<std::uint32_t, std::vector<std::uint32_t> > by;
+
+public:
+	static constexpr std::uint32_t none = ~0u;
+
+	static std::uint32_t placement(unsigned int face, unsigned int brick,
+				       unsigned int orientation) noexcept;
+
+	void add(std::uint32_t key, const std::vector<std::uint32_t>&);
+	// a nogood hashed by key whose placements are all among those by
+	// face, as its size followed by its placements, nullptr if none
+	const std::uint32_t *find(std::uint32_t key,
+				  const std::vector<std::uint32_t>& at) const;
+};
+
+inline std::uint32_t
+Nogoods::placement(unsigned int face, unsigned int brick, unsigned int orientation) noexcept {
+	return face << 16 | brick << 8 | orientation;
+}
+
+void
+Nogoods::add(std::uint32_t key, const std::vector<std::uint32_t>& v) {
+	if (placements.size() + v.size() + 1 > capacity)
+		return;
+	by[key].push_back(placements.size());
+	placements.push_back(v.size());
+	placements.insert(placements.end(), v.begin(), v.end());
+}
+
+const std::uint32_t *
+Nogoods::find(std::uint32_t key, const std::vector<std::uint32_t>& at) const {
+	auto i = by.find(key);
+	if (by.end() == i)
+		return nullptr;
+	for (std::uint32_t offset: i->second) {
+		const std::uint32_t *g = &placements[offset];
+		if (std::all_of(g + 1, g + 1 + g[0], [&at](std::uint32_t x) {
+			return at[x >> 16] == x;
+		}))
+			return g;
+	}
+	return nullptr;
+}
+
+}
+
+class Engine::Search {
+private:
+	// the conflict of a subtree that is no nogood: it has assemblies or
+	// it was cut short
+	static constexpr std::uint64_t all = ~std::uint64_t(0);
+
+	const Engine& engine;
+	// nullptr to count the assemblies up to limit
+	const std::function<bool(const Assembly&)> *visit;
+	unsigned long limit;
+
+	// the indices in the input of the bricks in the order of Brick, the
+	// bricks, their codes in each orientation, and their index
+	std::vector<unsigned int> order;
+	const std::vector<const Brick *> bricks;
+	std::vector<std::vector<std::uint16_t> > codes;
+	const SideIndex index;
+
+	Control *control;
+	// the share of the top level branches completed before the current
+	// one and its own share
+	double base, width;
+
+	const Plan *plan;
+	std::vector<Pick> picks;
+	std::vector<std::uint16_t> code;
+	std::vector<char> used;
+	Assembly assembly;
+	unsigned long count;
+	bool stop;
+
+	// with transpositions: the key of the partial assembly, and the part
+	// of it keying the bricks themselves
+	std::uint64_t key, salt;
+
+	// with nogoods: the slot of every brick used, the placement on every
+	// face, and the slot of every face in the plan
+	std::vector<unsigned int> where;
+	std::vector<std::uint32_t> at;
+	std::vector<unsigned int> slot_of;
+	Nogoods nogoods;
+
+public:
+	Search(const Engine&, const std::vector<Brick>&,
+	       const std::function<bool(const Assembly&)> *, unsigned long limit,
+	       Control *);
+
+	unsigned long run();
+
+private:
+	// Returns the conflict of the subtree, as bits: the slots before k
+	// whose bricks make it fail; all if it is no nogood or with nogoods
+	// off.
+	std::uint64_t place(unsigned int k);
+	bool fillable(unsigned int k, unsigned int slot, std::uint64_t& conflict) const noexcept;
+	void learn(unsigned int k, std::uint64_t conflict);
+	std::uint64_t slots(const std::uint32_t *nogood) const noexcept;
+	std::uint64_t cells(unsigned int face, std::uint16_t code) const noexcept;
+};
+
+Engine::Search::Search(const Engine& engine__, const std::vector<Brick>& bricks__,
+		       const std::function<bool(const Assembly&)> *visit__,
+		       unsigned long limit__, Control *control__)
+	: engine(engine__)
+	, visit(visit__)
+	, limit(limit__)
+	, bricks(sort(bricks__, order))
+	, index(bricks)
+	, control(control__)
+	, base(0)
+	, width(0)
+	, plan(nullptr)
+	, picks(bricks__.size())
+	, code(bricks__.size())
+	, used(bricks__.size(), 0)
+	, assembly(bricks__.size())
+	, count(0)
+	, stop(false)
+	, key(0)
+	, salt(14695981039346656037ull)
+	, where(bricks__.size(), 0)
+	, at(bricks__.size(), Nogoods::none)
+	, slot_of(bricks__.size(), 0)
+{
+	assert(bricks__.size() == engine.surface.faces().size());
+
+	for (const Brick *b: bricks) {
+		codes.emplace_back();
+		for (unsigned int o = 0; o < b->degree(); ++o)
+			codes.back().push_back(b->brick(o).code());
+		// the bricks are told apart by their first orientations
+		salt = (salt ^ codes.back().front()) * 1099511628211ull;
+	}
+}
+
+unsigned long
+Engine::Search::run() {
+	const Brick& first = *bricks.front();
+	std::vector<std::pair<const Plan *, unsigned int> > branches;
+	for (const Plan& p: engine.plans)
+		for (unsigned int o = 0; o < first.degree(); ++o) {
+			bool least = true;
+			for (unsigned int n: p.turns) {
+				std::uint16_t c = BrickB::transform(first.brick(o).code(), n);
+				unsigned int k = 0;
+				while (first.brick(k).code() != c)
+					++k;
+				least = least && k >= o;
+			}
+			if (least)
+				branches.emplace_back(&p, o);
+		}
+
+	width = 1.0 / branches.size();
+	for (unsigned int i = 0; i < branches.size(); ++i) {
+		plan = branches[i].first;
+		base = i * width;
+		unsigned int o = branches[i].second;
+		for (unsigned int s = 0; s < plan->slots.size(); ++s)
+			slot_of[plan->slots[s].face] = s;
+		picks[0] = Pick{0, o};
+		code[0] = first.brick(o).code();
+		used[0] = 1;
+		at[plan->slots[0].face] = Nogoods::placement(plan->slots[0].face, 0, o);
+		key = salt ^ engine.zobrist_plans[plan - engine.plans.data()] ^
+			engine.zobrist_bricks[0] ^ cells(plan->slots[0].face, code[0]);
+		place(1);
+		at[plan->slots[0].face] = Nogoods::none;
+		used[0] = 0;
+		if (stop)
+			return count;
+	}
+	if (control)
+		control->done(1);
+	return count;
+}
+
+std::uint64_t
+Engine::Search::place(unsigned int k) {
+	if (control && !control->node()) {
+		stop = true;
+		return all;
+	}
+	if (bricks.size() == k) {
+		if (!visit) {
+			stop = ++count >= limit;
+			return all;
+		}
+		for (unsigned int i = 0; i < k; ++i)
+			assembly[plan->slots[i].face] =
+				Pick{order[picks[i].brick], picks[i].orientation};
+		++count;
+		if (!(*visit)(assembly))
+			stop = true;
+		return all;
+	}
+
+	const bool learning = engine.nogoods;
+	const std::uint64_t placed = below(k);
+	Transpositions *table = engine.transpositions;
+	const unsigned long before = count;
+	if (table) {
+		std::uint64_t stored;
+		if (table->find(key, stored)) {
+			if (0 == stored)
+				// the slots placed are a nogood
+				return placed;
+			if (!visit) {
+				count = std::min<std::uint64_t>(count + stored, limit);
+				stop = count >= limit;
+				return all;
+			}
+		}
+	}
+
+	// the cells of the brick on slot k closing junctions: mask, and
+	// those that have to be filled: value
+	unsigned int mask = 0, value = 0;
+	for (const Check& c: plan->slots[k].checks) {
+		unsigned int filled = 0;
+		for (const Cell& e: c.others)
+			filled += code[e.face] >> e.cell & 1;
+		if (filled > 1)
+			return c.slots;
+		mask |= 1u << c.cell;
+		if (0 == filled)
+			value |= 1u << c.cell;
+	}
+
+	// the reasons the candidates tried so far fail, and whether one of
+	// them is a nogood without slot k, failing all the others too
+	std::uint64_t conflict = 0;
+	bool jump = false;
+	auto mismatch = [this, k](std::uint16_t c, unsigned int value) {
+		std::uint64_t r = 0;
+		for (const Check& x: plan->slots[k].checks)
+			if ((c >> x.cell & 1) != (value >> x.cell & 1))
+				r |= x.slots;
+		return r;
+	};
+	if (learning)
+		// the first brick would fit but is on slot 0
+		for (std::uint16_t c: codes[0])
+			if ((c & mask) == value)
+				conflict |= 1;
+
+	auto attempt = [&](unsigned int b, unsigned int o) {
+		std::uint16_t c = codes[b][o];
+		if ((c & mask) != value) {
+			if (learning)
+				conflict |= mismatch(c & mask, value);
+			return;
+		}
+		if (used[b]) {
+			conflict |= bit(where[b]);
+			return;
+		}
+		// equal bricks are placed in the order of their indices
+		if (!used[b - 1] && *bricks[b] == *bricks[b - 1]) {
+			conflict |= placed;
+			return;
+		}
+		unsigned int face = plan->slots[k].face;
+		std::uint32_t p = Nogoods::placement(face, b, o);
+		if (learning)
+			if (const std::uint32_t *g = nogoods.find(p, at)) {
+				conflict |= slots(g);
+				jump = 0 == (slots(g) >> k & 1);
+				return;
+			}
+		picks[k] = Pick{b, o};
+		code[k] = c;
+		used[b] = 1;
+		where[b] = k;
+		at[face] = p;
+		std::uint64_t failed = 0;
+		const std::vector<unsigned int>& ahead = plan->slots[k].ahead;
+		bool fits = std::all_of(ahead.begin(), ahead.end(),
+					[this, k, &failed](unsigned int s) {
+						return fillable(k, s, failed);
+					});
+		if (fits) {
+			const std::uint64_t z = engine.zobrist_bricks[b] ^ cells(face, c);
+			key ^= z;
+			failed = place(k + 1);
+			key ^= z;
+			if (learning && all != failed)
+				learn(k, failed);
+		}
+		conflict |= failed;
+		jump = learning && all != failed && 0 == (failed >> k & 1);
+		at[face] = Nogoods::none;
+		used[b] = 0;
+	};
+
+	const Slot& slot = plan->slots[k];
+	auto share = [this, k](std::size_t i, std::size_t n) {
+		if (1 == k && control)
+			control->done(base + width * i / n);
+	};
+	if (4 == slot.side) {
+		for (unsigned int b = 1; b < bricks.size() && !stop && !jump; ++b) {
+			share(b - 1, bricks.size() - 1);
+			for (unsigned int o = 0; o < codes[b].size() && !stop && !jump; ++o)
+				attempt(b, o);
+		}
+	} else {
+		// the candidates left out do not match the cells of the side
+		for (const Check& x: slot.checks)
+			if (x.cell / 4 == slot.side || (x.cell + 15) / 4 % 4 == slot.side)
+				conflict |= x.slots;
+		std::span<const Pick> candidates = index.fitting(slot.side,
+							     SideIndex::facing(slot.side, mask, value));
+		for (std::size_t i = 0; i < candidates.size() && !stop && !jump; ++i) {
+			share(i, candidates.size());
+			if (0 == candidates[i].brick)
+				continue;
+			attempt(candidates[i].brick, candidates[i].orientation);
+		}
+	}
+
+	if (table && !stop)
+		table->store(key, count - before, k);
+	if (!learning || stop || all == conflict)
+		return all;
+	return conflict & ~bit(k);
+}
+
+// the key of the junctions filled by a brick on a face
+inline std::uint64_t
+Engine::Search::cells(unsigned int face, std::uint16_t code) const noexcept {
+	std::uint64_t r = 0;
+	for (; 0 != code; code &= code - 1)
+		r ^= engine.zobrist_cells[face][__builtin_ctz(code)];
+	return r;
+}
+
+// the slots of the placements of a nogood
+std::uint64_t
+Engine::Search::slots(const std::uint32_t *g) const noexcept {
+	std::uint64_t r = 0;
+	for (std::uint32_t i = 1; i <= g[0]; ++i)
+		r |= std::uint64_t(1) << slot_of[g[i] >> 16];
+	return r;
+}
+
+// records that the placements on the slots of conflict, up to k, are in no
+// assembly; none of them at all means that there is no assembly
+void
+Engine::Search::learn(unsigned int k, std::uint64_t conflict) {
+	if (0 == conflict) {
+		stop = true;
+		return;
+	}
+	std::vector<std::uint32_t> v;
+	unsigned int last = 0;
+	for (unsigned int s = 0; s <= k; ++s)
+		if (conflict >> s & 1) {
+			v.push_back(at[plan->slots[s].face]);
+			last = s;
+		}
+	nogoods.add(at[plan->slots[last].face], v);
+}
+
+// Whether an unused brick fits a later slot next to the bricks placed up to
+// slot k. If not, adds to conflict the slots of the bricks next to it and
+// of the bricks used that would fit it.
+bool
+Engine::Search::fillable(unsigned int k, unsigned int slot,
+			 std::uint64_t& conflict) const noexcept {
+	const std::uint64_t placed = below(k + 1);
+	unsigned int mask = 0, value = 0;
+	std::uint64_t neighbours = 0;
+	for (const Check& c: plan->slots[slot].checks) {
+		unsigned int filled = 0;
+		bool all = true;
+		for (const Cell& e: c.others)
+			if (e.face <= k)
+				filled += code[e.face] >> e.cell & 1;
+			else
+				all = false;
+		neighbours |= c.slots & placed;
+		if (filled > 1) {
+			conflict |= c.slots & placed;
+			return false;
+		}
+		if (1 == filled)
+			mask |= 1u << c.cell;
+		else if (all) {
+			mask |= 1u << c.cell;
+			value |= 1u << c.cell;
+		}
+	}
+
+	std::uint64_t holders = 0;
+	for (unsigned int b = 0; b < bricks.size(); ++b)
+		for (std::uint16_t c: codes[b])
+			if ((c & mask) == value) {
+				if (!used[b])
+					return true;
+				holders |= bit(where[b]);
+				break;
+			}
+	conflict |= neighbours | holders;
+	return false;
+}
+
+unsigned long
+Engine::solve(const std::vector<Brick>& bricks,
+	      const std::function<bool(const Assembly&)>& visit) const {
+	return Search(*this, bricks, &visit, 0, nullptr).run();
+}
+
+unsigned long
+Engine::solve(const std::vector<Brick>& bricks,
+	      const std::function<bool(const Assembly&)>& visit,
+	      Control& control) const {
+	return Search(*this, bricks, &visit, 0, &control).run();
+}
+
+unsigned long
+Engine::count(const std::vector<Brick>& bricks, unsigned long limit) const {
+	if (transpositions)
+		return Search(*this, bricks, nullptr, std::max(limit, 1ul), nullptr).run();
+	unsigned long n = 0;
+	std::function<bool(const Assembly&)> visit = [&n, limit](const Assembly&) {
+		return ++n < limit;
+	};
+	return solve(bricks, visit);
+}
+
+bool
+Engine::find(const std::vector<Brick>& bricks, Assembly& a) const {
+	std::function<bool(const Assembly&)> visit = [&a](const Assembly& s) {
+		a = s;
+		return false;
+	};
+	return 0 != solve(bricks, visit);
+}
+
+}
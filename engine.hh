@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include "brick.hh"
+#include "surface.hh"
+#include "control.hh"
+#include "transpositions.hh"
+
+namespace happy_cube {
+
+// the bricks on the faces of a surface, by face
+typedef std::vector<Pick> Assembly;
+
+// Assembles as many bricks as there are faces on any surface, e.g. on the
+// surface of a polycube. The junctions of the surface are compiled, for an
+// order of the faces, into the junctions each brick closes with the bricks
+// placed before it, such that a candidate is checked by masking its code.
+class Engine {
+private:
+	// a junction closed by the brick on a slot: its cell on that brick
+	// and the cells on the bricks of earlier slots, Cell::face being the
+	// slot
+	struct Check {
+		unsigned int cell;
+		std::vector<Cell> others;
+		// the slots of the others, as bits
+		std::uint64_t slots;
+	};
+
+	struct Slot {
+		unsigned int face;
+		std::vector<Check> checks;
+		// a side whose middle cells are all checked, by which the
+		// candidates are looked up in SideIndex, 4 if there is none
+		unsigned int side;
+		// the later slots with junctions on this one, checked ahead for
+		// a brick still fitting them
+		std::vector<unsigned int> ahead;
+	};
+
+	// The faces in the order of placing, the first one having the first
+	// brick. The first brick is turned only by the orientations not
+	// mapped on lesser ones by the turns of the symmetries fixing the
+	// first face.
+	struct Plan {
+		std::vector<Slot> slots;
+		std::vector<unsigned int> turns;
+	};
+
+	const Surface& surface;
+	// one plan per class of faces mapped on one another by symmetries
+	std::vector<Plan> plans;
+	bool nogoods;
+	Transpositions *transpositions;
+	// the random keys of the junctions, by face and cell, and of the
+	// bricks, by index in the order of Brick, and of the plans
+	std::vector<std::array<std::uint64_t, 16> > zobrist_cells;
+	std::vector<std::uint64_t> zobrist_bricks, zobrist_plans;
+
+public:
+	// With nogoods, a search records the sets of placements under which
+	// a subtree failed, by conflict analysis, and cuts the subtrees that
+	// contain one of them. It does so on surfaces of up to 64 faces.
+	//
+	// With transpositions, a search looks its partial assemblies up in
+	// the table, and stores the number of assemblies completing them. A
+	// partial assembly is keyed by the plan, the bricks used and the
+	// junctions its bricks fill, which are all the rest of the search
+	// depends on, hashed by Zobrist keys maintained as bricks are placed.
+	// The subtrees without assemblies are cut, count adds up the numbers
+	// of those with some. The table can be shared by the engines of a
+	// surface, and by threads.
+	Engine(const Surface&, bool nogoods = false, Transpositions * = nullptr);
+
+	const Surface& shape() const noexcept;
+
+	// Calls visit for every assembly of the bricks, one per face, with
+	// the first brick (in the order of Brick) on the first face of a
+	// plan, until visit returns false. Returns the number of assemblies
+	// visited.
+	unsigned long solve(const std::vector<Brick>&,
+			    const std::function<bool(const Assembly&)>& visit) const;
+	// the same, stopping on the deadline or the cancellation of control,
+	// the top level branches being the orientations of the first brick
+	// and the candidates for the second slot
+	unsigned long solve(const std::vector<Brick>&,
+			    const std::function<bool(const Assembly&)>& visit,
+			    Control& control) const;
+	unsigned long count(const std::vector<Brick>&, unsigned long limit) const;
+	bool find(const std::vector<Brick>&, Assembly&) const;
+
+private:
+	class Search;
+
+	Plan plan(unsigned int first) const;
+};
+
+inline const Surface&
+Engine::shape() const noexcept {
+	return surface;
+}
+
+}
@@ -0,0 +1,93 @@
+#include "generate.hh"
+#include "assemble.hh"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace happy_cube {
+
+Generator::Generator(const Surface& surface__, std::uint64_t seed)
+	: surface(surface__)
+	, rng(seed)
+{
+	const std::vector<Junction>& junctions = surface.junctions();
+	std::vector<bool> taken(junctions.size(), false);
+	for (unsigned int f = 0; f < surface.faces().size(); ++f) {
+		for (std::size_t j = 0; j < junctions.size(); ++j) {
+			if (taken[j])
+				continue;
+			auto k = std::find_if(junctions[j].begin(), junctions[j].end(),
+					      [f](const Cell& c) {
+						      return c.face == f;
+					      });
+			if (junctions[j].end() != k) {
+				taken[j] = true;
+				order.push_back(&junctions[j]);
+			}
+		}
+		done.push_back(order.size());
+	}
+}
+
+bool
+Generator::cut(std::vector<std::uint16_t>& codes) {
+	codes.assign(surface.faces().size(), 0);
+	std::size_t j = 0;
+	for (unsigned int f = 0; f < done.size(); ++f) {
+		for (; j < done[f]; ++j) {
+			const Junction& junction = *order[j];
+			std::uniform_int_distribution<std::size_t> d(0, junction.size() - 1);
+			const Cell& c = junction[d(rng)];
+			codes[c.face] |= 1 << c.cell;
+		}
+		// brick f does not change any more
+		if (!BrickB::from_code(codes[f]).valid())
+			return false;
+	}
+	return true;
+}
+
+Puzzle
+Generator::puzzle() {
+	std::vector<std::uint16_t> codes;
+	std::uniform_int_distribution<unsigned int> orientation(0, 7);
+	for (;;) {
+		if (!cut(codes))
+			continue;
+
+		Puzzle p;
+		std::shuffle(codes.begin(), codes.end(), rng);
+		for (std::size_t i = 0; i < p.size(); ++i)
+			p[i] = BrickB::from_code(codes[i]).t(orientation(rng)).code();
+
+		std::vector<std::reference_wrapper<const Brick> > b(p.bricks());
+		if (1 == Solution::count(b[0], b[1], b[2], b[3], b[4], b[5], 2))
+			return p;
+	}
+}
+
+std::vector<Puzzle>
+generate(std::size_t n, unsigned int threads, std::uint64_t seed) {
+	std::vector<Puzzle> puzzles(n);
+	std::atomic<std::size_t> next(0);
+
+	std::vector<std::thread> workers;
+	workers.reserve(threads);
+	for (unsigned int i = 0; i < threads; ++i)
+		workers.emplace_back([&puzzles, &next, seed, i]() {
+			std::seed_seq s{static_cast<std::uint32_t>(seed),
+					static_cast<std::uint32_t>(seed >> 32), i};
+			std::array<std::uint32_t, 2> v;
+			s.generate(v.begin(), v.end());
+			Generator g(Surface::cube(),
+				    v[0] | static_cast<std::uint64_t>(v[1]) << 32);
+			for (std::size_t k = next++; k < puzzles.size(); k = next++)
+				puzzles[k] = g.puzzle();
+		});
+	for (std::thread& t: workers)
+		t.join();
+
+	return puzzles;
+}
+
+}
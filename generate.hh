@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include <random>
+#include <cstdint>
+#include "surface.hh"
+#include "puzzle.hh"
+
+namespace happy_cube {
+
+// Generates puzzles by cutting random surfaces into bricks instead of
+// searching combinations of catalogue bricks.
+class Generator {
+private:
+	const Surface& surface;
+	std::mt19937_64 rng;
+
+	// the junctions ordered such that the bricks are completed one by
+	// one, done[f] is the number of junctions after which brick f is
+	// complete
+	std::vector<const Junction *> order;
+	std::vector<std::size_t> done;
+
+public:
+	Generator(const Surface&, std::uint64_t seed);
+
+	// Assigns every junction to one of its cells at random. Returns
+	// false as soon as a brick turns out not to be valid.
+	bool cut(std::vector<std::uint16_t>&);
+
+	// a random cube puzzle with a unique solution, the bricks shuffled
+	// and in random orientations
+	Puzzle puzzle();
+};
+
+// n uniquely solvable puzzles generated by several threads, each with its
+// own random generator derived from seed
+extern std::vector<Puzzle> generate(std::size_t n, unsigned int threads,
+				    std::uint64_t seed);
+
+}
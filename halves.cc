@@ -0,0 +1,391 @@
+#include "halves.hh"
+#include "symmetry.hh"
+#include "index.hh"
+#include <algorithm>
+#include <cassert>
+
+namespace happy_cube {
+
+Halves::Halves()
+	: boundary(0)
+{
+	const Surface& cube = Surface::cube();
+	const std::vector<Junction>& junctions = cube.junctions();
+
+	// the first half is around a corner of the first face, the faces are
+	// in their order within each half
+	auto corner = std::find_if(junctions.begin(), junctions.end(),
+				   [](const Junction& j) {
+					   return 3 == j.size() &&
+						   j.end() != std::find_if(j.begin(), j.end(),
+									   [](const Cell& c) {
+										   return 0 == c.face;
+									   });
+				   });
+	assert(junctions.end() != corner);
+	std::array<unsigned int, 6> half, position;
+	half.fill(1);
+	for (const Cell& c: *corner)
+		half[c.face] = 0;
+	std::array<unsigned int, 2> n{0, 0};
+	for (unsigned int f = 0; f < half.size(); ++f) {
+		position[f] = n[half[f]]++;
+		halves[half[f]].faces[position[f]] = f;
+	}
+
+	unsigned int bits = 0;
+	for (const Junction& j: junctions) {
+		unsigned int h = half[j.front().face];
+		if (j.end() != std::find_if(j.begin(), j.end(),
+					    [&half, h](const Cell& c) {
+						    return half[c.face] != h;
+					    })) {
+			for (const Cell& c: j)
+				halves[half[c.face]].shared[position[c.face]].emplace_back(c.cell, bits);
+			boundary |= 1u << bits++;
+			continue;
+		}
+
+		// closed by the cell of the last position
+		auto last = std::max_element(j.begin(), j.end(),
+					     [&position](const Cell& a, const Cell& b) {
+						     return position[a.face] < position[b.face];
+					     });
+		Check check{last->cell, {}};
+		for (const Cell& c: j)
+			if (&c != &*last)
+				check.others.push_back(Cell{position[c.face], c.cell});
+		halves[h].checks[position[last->face]].push_back(std::move(check));
+	}
+	assert(bits <= 32);
+
+	for (Half& x: halves)
+		for (unsigned int p = 0; p < x.faces.size(); ++p) {
+			x.decided[p] = 0;
+			for (unsigned int q = 0; q < x.faces.size(); ++q)
+				for (const std::pair<unsigned int, unsigned int>& s: x.shared[q])
+					if (q <= p)
+						x.decided[p] |= 1u << s.second;
+			for (unsigned int q = p + 1; q < x.faces.size(); ++q)
+				for (const std::pair<unsigned int, unsigned int>& s: x.shared[q])
+					x.decided[p] &= ~(1u << s.second);
+
+			x.side[p] = 4;
+			for (unsigned int side = 0; side < 4 && 4 == x.side[p]; ++side)
+				if (3 == std::count_if(x.checks[p].begin(), x.checks[p].end(),
+						       [side](const Check& c) {
+							       return c.cell / 4 == side &&
+								       0 != c.cell % 4;
+						       }))
+					x.side[p] = side;
+		}
+
+	for (const Symmetry& s: symmetries(cube))
+		if (0 == s.face[0])
+			turns.push_back(s.turn[0]);
+}
+
+// the bricks in the order of Brick grouped into kinds of equal bricks: the
+// first brick of every kind, and the indices of the bricks of every kind
+static std::vector<const Brick *>
+group(const std::vector<Brick>& bricks, std::vector<std::vector<unsigned int> >& members) {
+	std::vector<unsigned int> order;
+	for (unsigned int i = 0; i < bricks.size(); ++i)
+		order.push_back(i);
+	std::sort(order.begin(), order.end(),
+		  [&bricks](unsigned int i, unsigned int j) {
+			  return bricks[i] < bricks[j];
+		  });
+	std::vector<const Brick *> r;
+	for (unsigned int i = 0; i < order.size(); ++i) {
+		if (0 == i || !(bricks[order[i]] == bricks[order[i - 1]])) {
+			r.push_back(&bricks[order[i]]);
+			members.emplace_back();
+		}
+		members.back().push_back(order[i]);
+	}
+	return r;
+}
+
+// The search of one set of bricks. The equal bricks are grouped into kinds,
+// such that the halves are enumerated by kind and every assembly is found
+// once. The bricks of a kind are given to the faces in the order of their
+// indices when an assembly is visited.
+class Halves::Join {
+private:
+	// the bits of the count of the bricks of a kind in a signature
+	static constexpr unsigned int width = 3;
+
+	// an assembly of a half, by position, and a signature: the shared
+	// junctions filled, above the number of bricks of every kind used; for
+	// the first half, the signature of the second halves completing it
+	struct Entry {
+		std::array<unsigned char, 3> kind, orientation;
+		std::uint64_t key;
+	};
+
+	const Halves& halves;
+	const std::vector<Brick>& bricks;
+	const std::function<bool(const Assembly&)> *visit;
+	Control *control;
+
+	// the indices of the bricks of every kind, in the order of Brick, the
+	// first of them, the codes of every kind in each orientation, and the
+	// orientations of the first kind on the first face
+	std::vector<std::vector<unsigned int> > members;
+	const std::vector<const Brick *> kinds;
+	std::vector<std::vector<std::uint16_t> > codes;
+	std::vector<char> least;
+	// the orientations of the kinds by their sides, Pick::brick being the
+	// kind
+	const SideIndex sides;
+	// the signature of all the bricks, without the shared junctions
+	std::uint64_t all;
+
+	// the assemblies of the first half, by the signature completing them:
+	// those in [start[t], start[t + 1]) are completed by signature
+	// wanted[t]
+	std::vector<Entry> entries;
+	std::vector<std::uint64_t> wanted;
+	std::vector<unsigned int> start;
+	// the signatures that the assembly of the second half up to each
+	// position can still complete to
+	std::array<std::vector<unsigned int>, 4> alive;
+
+	Entry entry;
+	std::array<std::uint16_t, 3> code;
+	unsigned long count;
+	unsigned long limit;
+	bool stop;
+
+public:
+	Join(const Halves&, const std::vector<Brick>&,
+	     const std::function<bool(const Assembly&)> *, Control *);
+
+	// visits the assemblies, or counts them up to limit without a visit
+	unsigned long run(unsigned long limit);
+
+private:
+	void enumerate(unsigned int h, unsigned int p, std::uint32_t filled,
+		       std::uint64_t used);
+	void join(unsigned int t);
+	bool assemble(const Entry& first, const Entry& second);
+};
+
+Halves::Join::Join(const Halves& halves__, const std::vector<Brick>& bricks__,
+		   const std::function<bool(const Assembly&)> *visit__,
+		   Control *control__)
+	: halves(halves__)
+	, bricks(bricks__)
+	, visit(visit__)
+	, control(control__)
+	, kinds(group(bricks__, members))
+	, sides(kinds)
+	, all(0)
+	, count(0)
+	, limit(0)
+	, stop(false)
+{
+	assert(6 == bricks.size());
+
+	for (unsigned int k = 0; k < kinds.size(); ++k) {
+		codes.emplace_back();
+		for (unsigned int o = 0; o < kinds[k]->degree(); ++o)
+			codes.back().push_back(kinds[k]->brick(o).code());
+		all += std::uint64_t(members[k].size()) << width * k;
+	}
+
+	const std::vector<std::uint16_t>& first = codes.front();
+	for (unsigned int o = 0; o < first.size(); ++o) {
+		bool l = true;
+		for (unsigned int n: halves.turns) {
+			std::uint16_t c = BrickB::transform(first[o], n);
+			l = l && std::find(first.begin(), first.end(), c) >= first.begin() + o;
+		}
+		least.push_back(l);
+	}
+}
+
+unsigned long
+Halves::Join::run(unsigned long limit__) {
+	limit = limit__;
+	enumerate(0, 0, 0, 0);
+	if (!stop && !entries.empty()) {
+		std::stable_sort(entries.begin(), entries.end(),
+				 [](const Entry& a, const Entry& b) {
+					 return a.key < b.key;
+				 });
+		for (unsigned int i = 0; i < entries.size(); ++i)
+			if (wanted.empty() || wanted.back() != entries[i].key) {
+				alive[0].push_back(wanted.size());
+				wanted.push_back(entries[i].key);
+				start.push_back(i);
+			}
+		start.push_back(entries.size());
+		enumerate(1, 0, 0, 0);
+	}
+	if (control && !stop)
+		control->done(1);
+	return count;
+}
+
+// the assemblies of half h from position p on, the earlier positions
+// filling the shared junctions filled and using the bricks used; those of
+// the second half only while they can complete an assembly of the first
+void
+Halves::Join::enumerate(unsigned int h, unsigned int p, std::uint32_t filled,
+			std::uint64_t used) {
+	if (control && !control->node()) {
+		stop = true;
+		return;
+	}
+	const unsigned int shift = width * codes.size();
+	if (3 == p) {
+		if (0 == h) {
+			entry.key = std::uint64_t(halves.boundary & ~filled) << shift | (all - used);
+			entries.push_back(entry);
+			return;
+		}
+		entry.key = std::uint64_t(filled) << shift | used;
+		for (unsigned int t: alive[p])
+			if (wanted[t] == entry.key) {
+				join(t);
+				break;
+			}
+		return;
+	}
+
+	const Half& half = halves.halves[h];
+	// the cells closing junctions within the half: mask, and those that
+	// have to be filled: value
+	unsigned int mask = 0, value = 0;
+	for (const Check& x: half.checks[p]) {
+		unsigned int n = 0;
+		for (const Cell& e: x.others)
+			n += code[e.face] >> e.cell & 1;
+		if (n > 1)
+			return;
+		mask |= 1u << x.cell;
+		if (0 == n)
+			value |= 1u << x.cell;
+	}
+
+	// the first kind on the first face, the second half leaving one of
+	// its bricks there
+	const bool first = 0 == h && 0 == p;
+	auto attempt = [&](unsigned int k, unsigned int o) {
+		unsigned int left = members[k].size() - (1 == h && 0 == k);
+		std::uint16_t c = codes[k][o];
+		if ((used >> width * k & ((1u << width) - 1)) == left ||
+		    (c & mask) != value || (first && (0 != k || !least[o])))
+			return;
+		std::uint32_t f = filled;
+		for (const std::pair<unsigned int, unsigned int>& s: half.shared[p])
+			if (0 != (c >> s.first & 1)) {
+				if (0 != (f >> s.second & 1))
+					return;
+				f |= 1u << s.second;
+			}
+		std::uint64_t u = used + (std::uint64_t(1) << width * k);
+		if (1 == h) {
+			// the junctions filled agree with a signature on those
+			// filled so far, and take at most its bricks
+			std::vector<unsigned int>& next = alive[p + 1];
+			next.clear();
+			for (unsigned int t: alive[p]) {
+				std::uint32_t w = wanted[t] >> shift;
+				if (0 == (f & ~w) && 0 == ((f ^ w) & half.decided[p]) &&
+				    (u >> width * k & ((1u << width) - 1)) <=
+				    (wanted[t] >> width * k & ((1u << width) - 1)))
+					next.push_back(t);
+			}
+			if (next.empty())
+				return;
+		}
+		entry.kind[p] = k;
+		entry.orientation[p] = o;
+		code[p] = c;
+		enumerate(h, p + 1, f, u);
+	};
+
+	const unsigned int side = half.side[p];
+	if (4 == side) {
+		for (unsigned int k = 0; k < (first ? 1 : codes.size()) && !stop; ++k)
+			for (unsigned int o = 0; o < codes[k].size() && !stop; ++o)
+				attempt(k, o);
+		return;
+	}
+	for (const Pick& x: sides.fitting(side, SideIndex::facing(side, mask, value))) {
+		if (stop)
+			return;
+		attempt(x.brick, x.orientation);
+	}
+}
+
+// joins the assembly of the second half with those of the first half it
+// completes, of signature wanted[t]
+void
+Halves::Join::join(unsigned int t) {
+	if (!visit) {
+		count = std::min<unsigned long>(limit, count + start[t + 1] - start[t]);
+		stop = count >= limit;
+		return;
+	}
+	for (unsigned int e = start[t]; e < start[t + 1]; ++e)
+		if (!assemble(entries[e], entry))
+			return;
+}
+
+// visits the assembly of two halves, false to stop
+bool
+Halves::Join::assemble(const Entry& first, const Entry& second) {
+	std::array<std::pair<unsigned int, unsigned int>, 6> faces;
+	for (unsigned int p = 0; p < 3; ++p) {
+		faces[halves.halves[0].faces[p]] = {first.kind[p], first.orientation[p]};
+		faces[halves.halves[1].faces[p]] = {second.kind[p], second.orientation[p]};
+	}
+
+	Assembly a(faces.size());
+	std::vector<unsigned int> next(codes.size(), 0);
+	for (unsigned int f = 0; f < faces.size(); ++f) {
+		unsigned int k = faces[f].first;
+		unsigned int b = members[k][next[k]++];
+		std::uint16_t c = codes[k][faces[f].second];
+		unsigned int o = 0;
+		while (bricks[b].brick(o).code() != c)
+			++o;
+		a[f] = Pick{b, o};
+	}
+	++count;
+	stop = !(*visit)(a);
+	return !stop;
+}
+
+unsigned long
+Halves::solve(const std::vector<Brick>& bricks,
+	      const std::function<bool(const Assembly&)>& visit) const {
+	return Join(*this, bricks, &visit, nullptr).run(0);
+}
+
+unsigned long
+Halves::solve(const std::vector<Brick>& bricks,
+	      const std::function<bool(const Assembly&)>& visit,
+	      Control& control) const {
+	return Join(*this, bricks, &visit, &control).run(0);
+}
+
+unsigned long
+Halves::count(const std::vector<Brick>& bricks, unsigned long limit) const {
+	return Join(*this, bricks, nullptr, nullptr).run(std::max(limit, 1ul));
+}
+
+bool
+Halves::find(const std::vector<Brick>& bricks, Assembly& a) const {
+	std::function<bool(const Assembly&)> visit = [&a](const Assembly& s) {
+		a = s;
+		return false;
+	};
+	return 0 != solve(bricks, visit);
+}
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <cstdint>
+#include "brick.hh"
+#include "surface.hh"
+#include "engine.hh"
+#include "control.hh"
+
+namespace happy_cube {
+
+// Assembles six bricks on Surface::cube() by meeting in the middle. The cube
+// is split into two halves, the three faces around a corner of the first
+// face and the three around the opposite corner. The assemblies of either
+// half closing the junctions within it are enumerated. Those of the first
+// half are grouped by the signature of the assemblies of the second half
+// completing them: the cells these fill on the junctions shared with the
+// first half, and the bricks they use. The second half is then searched
+// only while the cells it fills on the shared junctions and its bricks
+// agree with one of those signatures, and each of its assemblies is joined
+// with the assemblies of the first half it completes.
+//
+// The assemblies are the ones of Engine on the cube: the first brick (in the
+// order of Brick) on the first face, turned only by the orientations not
+// mapped on lesser ones by the symmetries fixing that face, and equal bricks
+// in the order of their indices by face.
+class Halves {
+private:
+	// a junction closed within a half by the brick on a position: its
+	// cell on that brick and the cells on the bricks of earlier
+	// positions, Cell::face being the position
+	struct Check {
+		unsigned int cell;
+		std::vector<Cell> others;
+	};
+
+	struct Half {
+		std::array<unsigned int, 3> faces;
+		std::array<std::vector<Check>, 3> checks;
+		// a side of each position whose middle cells are all checked,
+		// by which the candidates are looked up in SideIndex, 4 if
+		// there is none
+		std::array<unsigned int, 3> side;
+		// the cells of each position on junctions shared with the
+		// other half, with the bits of those junctions
+		std::array<std::vector<std::pair<unsigned int, unsigned int> >, 3> shared;
+		// the shared junctions whose cells in the half are all on the
+		// positions up to each one
+		std::array<std::uint32_t, 3> decided;
+	};
+
+	std::array<Half, 2> halves;
+	// the shared junctions, as bits
+	std::uint32_t boundary;
+	// the turns of the first face by the symmetries fixing it
+	std::vector<unsigned int> turns;
+
+public:
+	Halves();
+
+	// Calls visit for every assembly of the bricks until visit returns
+	// false. Returns the number of assemblies visited.
+	unsigned long solve(const std::vector<Brick>&,
+			    const std::function<bool(const Assembly&)>& visit) const;
+	// the same, stopping on the deadline or the cancellation of control
+	unsigned long solve(const std::vector<Brick>&,
+			    const std::function<bool(const Assembly&)>& visit,
+			    Control& control) const;
+	// the number of assemblies, up to limit, from the sizes of the
+	// buckets joined, without building them
+	unsigned long count(const std::vector<Brick>&, unsigned long limit) const;
+	bool find(const std::vector<Brick>&, Assembly&) const;
+
+private:
+	class Join;
+};
+
+}
@@ -0,0 +1,176 @@
+#include "hints.hh"
+#include <algorithm>
+#include <cassert>
+
+namespace happy_cube {
+
+Hints::Hints(std::vector<Brick>&& bricks__)
+	: bricks(std::move(bricks__))
+	, keys(bricks.size())
+{
+	assert(6 == bricks.size());
+
+	for (unsigned int b = 0; b < bricks.size(); ++b) {
+		codes.emplace_back();
+		for (unsigned int o = 0; o < bricks[b].degree(); ++o)
+			codes.back().push_back(bricks[b].brick(o).code());
+		unsigned int f = 0;
+		while (bricks[f] != bricks[b])
+			++f;
+		first.push_back(f);
+		for (unsigned int o = 0; o < codes[b].size(); ++o) {
+			unsigned int e = 0;
+			while (codes[f][e] != codes[b][o])
+				++e;
+			keys[b][o] = 1 + f * 8 + e;
+		}
+	}
+
+	for (const Junction& j: Surface::cube().junctions())
+		for (const Cell& c: j) {
+			Check check{c.cell, {}};
+			for (const Cell& e: j)
+				if (e.face != c.face)
+					check.others.push_back(e);
+			checks[c.face].push_back(std::move(check));
+		}
+}
+
+std::vector<Pick>
+Hints::fitting(const Cube& partial, unsigned int face) {
+	std::vector<Pick> r;
+	if (none != partial[face].brick || !completes(partial))
+		return r;
+
+	unsigned int mask, value;
+	fits(partial, face, mask, value);
+	std::vector<char> used(bricks.size(), 0);
+	for (const Pick& p: partial)
+		if (none != p.brick)
+			used[p.brick] = 1;
+	Cube c(partial);
+	for (unsigned int b = 0; b < bricks.size(); ++b) {
+		if (used[b])
+			continue;
+		used[b] = 1;
+		for (unsigned int o = 0; o < codes[b].size(); ++o) {
+			if ((codes[b][o] & mask) != value)
+				continue;
+			c[face] = Pick{b, o};
+			if (search(c, used))
+				r.push_back(c[face]);
+		}
+		used[b] = 0;
+	}
+	return r;
+}
+
+bool
+Hints::completes(const Cube& partial) {
+	// the bricks on the faces have to be distinct and to fit one another
+	std::vector<char> used(bricks.size(), 0);
+	for (unsigned int f = 0; f < partial.size(); ++f) {
+		const Pick& p = partial[f];
+		if (none == p.brick)
+			continue;
+		unsigned int mask, value;
+		if (p.brick >= bricks.size() || used[p.brick] ||
+		    p.orientation >= codes[p.brick].size() ||
+		    !fits(partial, f, mask, value) ||
+		    (codes[p.brick][p.orientation] & mask) != value)
+			return false;
+		used[p.brick] = 1;
+	}
+	Cube c(partial);
+	return search(c, used);
+}
+
+// The cells of the brick on face closing junctions with the bricks of
+// partial: mask, and those that have to be filled: value. A cell whose
+// junction is filled has to be empty. False if a junction is filled twice.
+bool
+Hints::fits(const Cube& partial, unsigned int face, unsigned int& mask,
+	    unsigned int& value) const noexcept {
+	mask = 0;
+	value = 0;
+	for (const Check& c: checks[face]) {
+		unsigned int filled = 0;
+		bool closed = true;
+		for (const Cell& e: c.others) {
+			const Pick& p = partial[e.face];
+			if (none == p.brick)
+				closed = false;
+			else
+				filled += codes[p.brick][p.orientation] >> e.cell & 1;
+		}
+		if (filled > 1)
+			return false;
+		if (closed || 1 == filled)
+			mask |= 1u << c.cell;
+		if (closed && 0 == filled)
+			value |= 1u << c.cell;
+	}
+	return true;
+}
+
+// the classes of the bricks on the faces and their orientations, 6 bits
+// per face, 0 for an empty face
+std::uint64_t
+Hints::key(const Cube& partial) const noexcept {
+	std::uint64_t r = 0;
+	for (unsigned int f = 0; f < partial.size(); ++f) {
+		const Pick& p = partial[f];
+		r |= std::uint64_t(none == p.brick ? 0 : keys[p.brick][p.orientation]) << 6 * f;
+	}
+	return r;
+}
+
+// Whether the bricks not used complete partial, whose bricks fit one
+// another. Fills the empty face with the most cells constrained first.
+bool
+Hints::search(Cube& partial, std::vector<char>& used) {
+	std::uint64_t k = key(partial);
+	auto i = memo.find(k);
+	if (memo.end() != i)
+		return i->second;
+
+	unsigned int face = none, mask = 0, value = 0;
+	for (unsigned int f = 0; f < partial.size(); ++f) {
+		unsigned int m, v;
+		if (none != partial[f].brick)
+			continue;
+		if (!fits(partial, f, m, v))
+			return memo[k] = false;
+		if (none == face || __builtin_popcount(m) > __builtin_popcount(mask)) {
+			face = f;
+			mask = m;
+			value = v;
+		}
+	}
+	if (none == face)
+		return memo[k] = true;
+
+	bool r = false;
+	for (unsigned int b = 0; b < bricks.size() && !r; ++b) {
+		// of equal bricks, only the first one unused is tried
+		if (used[b])
+			continue;
+		bool skip = false;
+		for (unsigned int e = first[b]; e < b; ++e)
+			skip = skip || (first[e] == first[b] && !used[e]);
+		if (skip)
+			continue;
+		used[b] = 1;
+		for (unsigned int o = 0; o < codes[b].size() && !r; ++o) {
+			if ((codes[b][o] & mask) != value)
+				continue;
+			partial[face] = Pick{b, o};
+			r = search(partial, used);
+		}
+		partial[face] = Pick{none, 0};
+		used[b] = 0;
+	}
+	return memo[k] = r;
+}
+
+}
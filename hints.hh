@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "brick.hh"
+#include "surface.hh"
+#include "pool.hh"
+
+namespace happy_cube {
+
+// Answers which bricks fit an empty face of a partially assembled cube such
+// that the cube can still be completed, e.g. as the hints of a game. The
+// junctions of every face and the orientations of the bricks are compiled
+// once. Whether a partial assembly can be completed is searched from that
+// assembly on, never from the foundation, and memoized along with the
+// partial assemblies met on the way, keyed by the classes of the bricks on
+// the faces, such that the queries of a game mostly hit the memo. Not
+// thread-safe.
+class Hints {
+public:
+	// the brick of an empty face
+	static constexpr unsigned int none = ~0u;
+
+private:
+	// a junction of a face: its cell and the cells of the other faces
+	struct Check {
+		unsigned int cell;
+		std::vector<Cell> others;
+	};
+
+	std::vector<Brick> bricks;
+	// the codes of the bricks in each orientation, and the brick equal
+	// to each one with the least index
+	std::vector<std::vector<std::uint16_t> > codes;
+	std::vector<unsigned int> first;
+	// for each brick and orientation, 1 + the first equal brick * 8 +
+	// its orientation of the same code, the key of the face it is on
+	std::vector<std::array<std::uint8_t, 8> > keys;
+	std::array<std::vector<Check>, 6> checks;
+
+	std::unordered_map<std::uint64_t, bool> memo;
+
+public:
+	// the six bricks of a puzzle
+	Hints(std::vector<Brick>&&);
+
+	const Brick& brick(unsigned int) const noexcept;
+
+	// The bricks and orientations that fit face, empty in partial, next
+	// to the bricks of partial, and complete the cube with the bricks not
+	// in partial. The faces of partial are those of Surface::cube(),
+	// Pick::brick being an index among the six bricks or none.
+	std::vector<Pick> fitting(const Cube& partial, unsigned int face);
+	// whether partial can be completed
+	bool completes(const Cube& partial);
+
+private:
+	bool fits(const Cube&, unsigned int face, unsigned int& mask,
+		  unsigned int& value) const noexcept;
+	std::uint64_t key(const Cube&) const noexcept;
+	bool search(Cube&, std::vector<char>& used);
+};
+
+inline const Brick&
+Hints::brick(unsigned int i) const noexcept {
+	return bricks[i];
+}
+
+}
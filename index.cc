@@ -0,0 +1,64 @@
+#include "index.hh"
+
+namespace happy_cube {
+
+SideIndex::SideIndex(const std::vector<Brick>& bricks) {
+	build(bricks.size(), [&bricks](unsigned int i) -> const Brick& {
+		return bricks[i];
+	});
+}
+
+SideIndex::SideIndex(const std::vector<const Brick *>& bricks) {
+	build(bricks.size(), [&bricks](unsigned int i) -> const Brick& {
+		return *bricks[i];
+	});
+}
+
+// Counts the entries of each side and code, then lays them out in place.
+// An orientation is entered under every code its side matches: the code
+// with the complemented middle cells and any corner cells not filled on
+// the side.
+template<typename F>
+void
+SideIndex::build(std::size_t n, F&& brick) {
+	auto codes = [](unsigned int s, auto&& f) {
+		unsigned int middle = ~s & 0xe;
+		for (unsigned int corners = 0; corners < 0x20; corners += 0x10)
+			for (unsigned int first = 0; first < 2; ++first) {
+				unsigned int c = middle | corners | first;
+				if (Side::match(c, s))
+					f(c);
+			}
+	};
+
+	for (std::array<unsigned int, 33>& s: start)
+		s.fill(0);
+	for (unsigned int i = 0; i < n; ++i)
+		for (unsigned int o = 0; o < brick(i).degree(); ++o) {
+			std::uint16_t k = brick(i).brick(o).code();
+			for (unsigned int side = 0; side < 4; ++side)
+				codes(BrickB::side(k, side), [this, side](unsigned int c) {
+					++start[side][c + 1];
+				});
+		}
+
+	unsigned int total = 0;
+	for (std::array<unsigned int, 33>& s: start)
+		for (unsigned int c = 0; c <= 32; ++c) {
+			total += s[c];
+			s[c] = total - s[c];
+		}
+	// start[n][c + 1] is now where the entries of c begin, it ends up
+	// where they end
+	entries.resize(total);
+	for (unsigned int i = 0; i < n; ++i)
+		for (unsigned int o = 0; o < brick(i).degree(); ++o) {
+			std::uint16_t k = brick(i).brick(o).code();
+			for (unsigned int side = 0; side < 4; ++side)
+				codes(BrickB::side(k, side), [this, side, i, o](unsigned int c) {
+					entries[start[side][c + 1]++] = Pick{i, o};
+				});
+		}
+}
+
+}
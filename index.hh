@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <span>
+#include "brick.hh"
+
+namespace happy_cube {
+
+// The orientations of several bricks, e.g. of a pool or of the catalogue,
+// by the codes of their sides. The orientations whose side n (0 top,
+// 1 right, 2 bottom, 3 left) matches a side of code c, i.e.
+// Side::match(c, BrickB::side(code, n)), are stored contiguously, in the
+// order of the bricks and of their orientations.
+class SideIndex {
+private:
+	std::vector<Pick> entries;
+	// the entries of side n matching code c are in
+	// [start[n][c], start[n][c + 1])
+	std::array<std::array<unsigned int, 33>, 4> start;
+
+public:
+	SideIndex(const std::vector<Brick>&);
+	SideIndex(const std::vector<const Brick *>&);
+
+	std::span<const Pick> fitting(unsigned int n, unsigned int c) const noexcept;
+
+	// the code to look up for side n of a face whose cells filled so far
+	// are mask, of value value: the complement of the middle cells of
+	// the side facing it, and its corner cells that have to be empty
+	static unsigned int facing(unsigned int n, unsigned int mask,
+				   unsigned int value) noexcept;
+
+private:
+	template<typename F>
+	void build(std::size_t, F&&);
+};
+
+inline std::span<const Pick>
+SideIndex::fitting(unsigned int n, unsigned int c) const noexcept {
+	return std::span<const Pick>(entries.data() + start[n][c],
+				     entries.data() + start[n][c + 1]);
+}
+
+inline unsigned int
+SideIndex::facing(unsigned int n, unsigned int mask, unsigned int value) noexcept {
+	unsigned int r = 0;
+	for (unsigned int i = 0; i < 5; ++i) {
+		unsigned int cell = (4 * n + i) % 16;
+		if (0 == (value >> cell & 1) && (0 != i % 4 || 0 != (mask >> cell & 1)))
+			r |= 1u << i;
+	}
+	return r;
+}
+
+}
@@ -0,0 +1,65 @@
+#include "intern.hh"
+#include "catalogue.hh"
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <memory>
+
+namespace happy_cube {
+
+namespace {
+
+class Interned {
+private:
+	// the brick of each code, nullptr until it is interned
+	std::unique_ptr<std::atomic<const Brick *>[]> table;
+	// the bricks that are not in the catalogue
+	std::deque<Brick> others;
+	std::mutex mutex;
+
+public:
+	Interned();
+
+	const Brick& get(std::uint16_t);
+
+private:
+	void enter(const Brick&) noexcept;
+};
+
+Interned::Interned()
+	: table(new std::atomic<const Brick *>[1 << 16])
+{
+	for (unsigned int c = 0; c < 1 << 16; ++c)
+		table[c].store(nullptr, std::memory_order_relaxed);
+	for (const Brick& b: catalogue())
+		enter(b);
+}
+
+void
+Interned::enter(const Brick& b) noexcept {
+	for (unsigned int o = 0; o < b.degree(); ++o)
+		table[b.brick(o).code()].store(&b, std::memory_order_release);
+}
+
+const Brick&
+Interned::get(std::uint16_t c) {
+	if (const Brick *b = table[c].load(std::memory_order_acquire))
+		return *b;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (const Brick *b = table[c].load(std::memory_order_acquire))
+		return *b;
+	others.emplace_back(BrickB::from_code(c));
+	enter(others.back());
+	return others.back();
+}
+
+}
+
+const Brick&
+intern(std::uint16_t c) {
+	static Interned bricks;
+	return bricks.get(c);
+}
+
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+#include "brick.hh"
+
+namespace happy_cube {
+
+// The brick of a code, shared by all the codes of its orientations and
+// by all threads. Its first orientation is the one of the catalogue, for
+// the bricks of the catalogue, or else the first code interned. Its
+// orientations are computed once, the bricks of the catalogue up front.
+extern const Brick& intern(std::uint16_t);
+
+}
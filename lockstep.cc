@@ -0,0 +1,269 @@
+#include "lockstep.hh"
+#include "intern.hh"
+#include "unrolled.hh"
+#include <algorithm>
+#include <cstring>
+
+namespace happy_cube {
+
+namespace {
+
+// the puzzles searched at once
+constexpr unsigned int lanes = 8;
+// the bricks in every orientation, brick * 8 + orientation
+constexpr unsigned int candidates = 48;
+constexpr std::size_t none = ~std::size_t(0);
+
+// a cell, or the bits of 16 candidates, of every lane
+typedef std::uint16_t Vector __attribute__((vector_size(2 * lanes)));
+
+// the candidates of a set of bricks
+constexpr std::uint64_t
+spread(unsigned int bricks) noexcept {
+	std::uint64_t r = 0;
+	for (unsigned int b = 0; b < 6; ++b)
+		if (0 != (bricks >> b & 1))
+			r |= std::uint64_t(0xff) << 8 * b;
+	return r;
+}
+
+// the search of the puzzle of a lane, the slots before depth being placed
+struct Lane {
+	std::size_t puzzle;
+	// the bricks in the order of Brick, by their indices in the puzzle
+	std::array<unsigned int, 6> order;
+	// the candidates that are orientations of their bricks, and the bricks
+	// equal to the one before them
+	std::uint64_t valid;
+	unsigned int same;
+
+	unsigned int depth;
+	// the candidates left on every slot, with the candidate placed, its
+	// code and the bricks used
+	std::array<std::uint64_t, 6> left;
+	std::array<unsigned int, 6> pick;
+	std::array<std::uint16_t, 6> code;
+	unsigned int used;
+	// the candidates of the slot at depth are to be checked
+	bool expand;
+};
+
+class Lockstep {
+private:
+	const std::vector<Puzzle>& puzzles;
+	std::vector<char>& found;
+	std::vector<Cube>& cubes;
+	std::size_t next;
+
+	std::array<Lane, lanes> lane;
+	// the codes of the candidates of all the lanes, and the cells of the
+	// slot of every lane closing junctions: mask, and those that have to
+	// be filled: value; written by lane, read as vectors
+	alignas(Vector) std::uint16_t codes[candidates][lanes];
+	alignas(Vector) std::uint16_t mask[lanes], value[lanes];
+
+public:
+	Lockstep(const std::vector<Puzzle>&, std::vector<char>&, std::vector<Cube>&);
+
+	void run();
+
+private:
+	bool step();
+	void load(unsigned int l);
+	void descend(unsigned int l);
+	void finish(unsigned int l, bool solved);
+};
+
+Lockstep::Lockstep(const std::vector<Puzzle>& puzzles__, std::vector<char>& found__,
+		   std::vector<Cube>& cubes__)
+	: puzzles(puzzles__)
+	, found(found__)
+	, cubes(cubes__)
+	, next(0)
+	, codes{}
+	, mask{}
+	, value{}
+{
+	for (unsigned int l = 0; l < lanes; ++l)
+		load(l);
+}
+
+void
+Lockstep::run() {
+	while (step())
+		;
+}
+
+// Checks the candidates of every lane to expand, and advances every lane by
+// one candidate, or back by one slot. False once all lanes are idle.
+bool
+Lockstep::step() {
+	Vector m, v;
+	std::memcpy(&m, mask, sizeof(m));
+	std::memcpy(&v, value, sizeof(v));
+	std::array<Vector, candidates / 16> fit{};
+	for (unsigned int j = 0; j < candidates; ++j) {
+		Vector c;
+		std::memcpy(&c, codes[j], sizeof(c));
+		Vector bit;
+		for (unsigned int l = 0; l < lanes; ++l)
+			bit[l] = 1u << j % 16;
+		fit[j / 16] |= reinterpret_cast<Vector>((c & m) == v) & bit;
+	}
+	alignas(Vector) std::uint16_t bits[candidates / 16][lanes];
+	std::memcpy(bits, fit.data(), sizeof(bits));
+
+	bool busy = false;
+	for (unsigned int l = 0; l < lanes; ++l) {
+		Lane& x = lane[l];
+		if (none == x.puzzle)
+			continue;
+		busy = true;
+		unsigned int d = x.depth;
+		if (x.expand) {
+			// equal bricks are placed in the order of their indices
+			x.left[d] = (bits[0][l] | std::uint64_t(bits[1][l]) << 16 |
+				     std::uint64_t(bits[2][l]) << 32) & x.valid &
+				~spread(x.used | (x.same & ~(x.used << 1)));
+			x.expand = false;
+		}
+		if (0 == x.left[d]) {
+			if (1 == d)
+				finish(l, false);
+			else {
+				x.depth = --d;
+				x.used &= ~(1u << x.pick[d] / 8);
+			}
+			continue;
+		}
+		unsigned int j = __builtin_ctzll(x.left[d]);
+		x.left[d] &= x.left[d] - 1;
+		x.pick[d] = j;
+		x.code[d] = codes[j][l];
+		x.used |= 1u << j / 8;
+		x.depth = ++d;
+		if (6 == d)
+			finish(l, true);
+		else
+			descend(l);
+	}
+	return busy;
+}
+
+// adds the cell of closure i of slot k to mask, and to value if none of the
+// others is filled, false if more than one of them is
+template<std::size_t k, std::size_t i>
+static bool
+close(const std::array<std::uint16_t, 6>& code, unsigned int& mask,
+      unsigned int& value) noexcept {
+	constexpr const Closure& x = cube_layout.closures[k][i];
+	unsigned int filled = [&code]<std::size_t... j>(std::index_sequence<j...>) {
+		return (0u + ... + (code[x.others[j].slot] >> x.others[j].cell & 1));
+	}(std::make_index_sequence<cube_layout.closures[k][i].count>());
+	mask |= 1u << x.cell;
+	value |= (0 == filled) << x.cell;
+	return filled < 2;
+}
+
+// the cells of slot k closing junctions with the slots before it, by fully
+// unrolled code as in Unrolled
+template<std::size_t k>
+static bool
+closes(const std::array<std::uint16_t, 6>& code, unsigned int& mask,
+       unsigned int& value) noexcept {
+	return [&code, &mask, &value]<std::size_t... i>(std::index_sequence<i...>) {
+		return (... && close<k, i>(code, mask, value));
+	}(std::make_index_sequence<cube_layout.count[k]>());
+}
+
+// the cells of the slot at depth closing junctions with the slots placed
+void
+Lockstep::descend(unsigned int l) {
+	typedef bool (*Close)(const std::array<std::uint16_t, 6>&, unsigned int&,
+			      unsigned int&) noexcept;
+	static constexpr Close slots[] = {closes<0>, closes<1>, closes<2>, closes<3>,
+					  closes<4>, closes<5>};
+	Lane& x = lane[l];
+	unsigned int m = 0, v = 0;
+	x.expand = slots[x.depth](x.code, m, v);
+	x.left[x.depth] = 0;
+	mask[l] = m;
+	value[l] = v;
+}
+
+void
+Lockstep::finish(unsigned int l, bool solved) {
+	Lane& x = lane[l];
+	found[x.puzzle] = solved;
+	if (solved)
+		for (unsigned int k = 0; k < x.pick.size(); ++k) {
+			unsigned int b = x.order[x.pick[k] / 8], o = 0;
+			const Brick& brick = intern(puzzles[x.puzzle][b]);
+			while (brick.brick(o).code() != x.code[k])
+				++o;
+			cubes[x.puzzle][cube_layout.face[k]] = Pick{b, o};
+		}
+	load(l);
+}
+
+// gives the next puzzle to a lane, with its first brick on the first slot
+// in its first orientation
+void
+Lockstep::load(unsigned int l) {
+	Lane& x = lane[l];
+	if (next == puzzles.size()) {
+		x.puzzle = none;
+		return;
+	}
+	x.puzzle = next++;
+	const Puzzle& p = puzzles[x.puzzle];
+
+	// The orientations by BrickB::transform of the codes of the puzzle,
+	// those equal to an earlier one left out, and the bricks sorted by
+	// their least orientations, which keeps equal bricks together. Brick
+	// and intern are left alone, their tables are too slow to reach for
+	// puzzles this small.
+	std::array<std::uint16_t, 6> least;
+	for (unsigned int i = 0; i < x.order.size(); ++i) {
+		x.order[i] = i;
+		least[i] = p[i];
+		for (unsigned int o = 1; o < 8; ++o)
+			least[i] = std::min(least[i], BrickB::transform(p[i], o));
+	}
+	std::sort(x.order.begin(), x.order.end(), [&least](unsigned int i, unsigned int j) {
+		return least[i] < least[j];
+	});
+
+	x.valid = 0;
+	x.same = 0;
+	for (unsigned int i = 0; i < x.order.size(); ++i) {
+		std::uint16_t *c = &codes[8 * i][0];
+		for (unsigned int o = 0; o < 8; ++o) {
+			c[o * lanes + l] = BrickB::transform(p[x.order[i]], o);
+			bool again = false;
+			for (unsigned int e = 0; e < o; ++e)
+				again = again || c[e * lanes + l] == c[o * lanes + l];
+			x.valid |= std::uint64_t(!again) << (8 * i + o);
+		}
+		if (i > 0 && least[x.order[i]] == least[x.order[i - 1]])
+			x.same |= 1u << i;
+	}
+
+	x.pick[0] = 0;
+	x.code[0] = codes[0][l];
+	x.used = 1;
+	x.depth = 1;
+	descend(l);
+}
+
+}
+
+std::vector<char>
+lockstep(const std::vector<Puzzle>& puzzles, std::vector<Cube>& cubes) {
+	std::vector<char> found(puzzles.size(), 0);
+	cubes.assign(puzzles.size(), Cube{});
+	Lockstep(puzzles, found, cubes).run();
+	return found;
+}
+
+}
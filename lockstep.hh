@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+#include "pool.hh"
+#include "puzzle.hh"
+
+namespace happy_cube {
+
+// The first assembly of every puzzle, searched for several puzzles at once,
+// one per lane of a vector. The searches of all the lanes advance by a node
+// per step, the candidates fitting the slot of every lane being checked by
+// the same vector operations, and a lane whose search ends takes the next
+// puzzle. The search is the one of Unrolled on cube_layout, without its
+// recursion, but the bricks are in the order of their orientations of least
+// code and the orientations in the order of BrickB::transform, not in the
+// orders of Brick, so the assembly found first may differ from that of
+// Solution::assemble. Returns whether each puzzle builds a cube, with its
+// assembly in cubes, the picks being the indices in the puzzle and the
+// orientations of intern.
+extern std::vector<char> lockstep(const std::vector<Puzzle>&, std::vector<Cube>& cubes);
+
+}
@@ -1,20 +1,77 @@
-#include "combinations.hh"
 #include "brick.hh"
 #include <iostream>
-#include <set>
 #include <algorithm>
 #include "assemble.hh"
+#include "batch.hh"
+#include "catalogue.hh"
+#include "census.hh"
+#include "complete.hh"
+#include "generate.hh"
+#include "intern.hh"
+#include "lockstep.hh"
+#include "neighbours.hh"
+#include "partial.hh"
+#include "pool.hh"
+#include "trace.hh"
+#include <string>
+#include <iomanip>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 using happy_cube::Brick;
 using happy_cube::BrickB;
 using happy_cube::Solution;
+using happy_cube::Puzzle;
+using happy_cube::Partial;
+using happy_cube::Pool;
+using happy_cube::Census;
+using happy_cube::Allocations;
+using happy_cube::Control;
+using happy_cube::Trace;
 
-static std::vector<Brick> generate_bricks();
+static int generate(int argc, char *argv[]);
+static int partial(int argc, char *argv[]);
+static int pool(int argc, char *argv[]);
+static int complete(int argc, char *argv[]);
+static int census(int argc, char *argv[]);
+static int solve(int argc, char *argv[]);
+static int lockstep(int argc, char *argv[]);
+static int near(int argc, char *argv[]);
 
 int
 main(int argc, char *argv[]) {
-	// std::vector<Brick> bricks = generate_bricks();
-	// for (const Brick& b: bricks)
+	// the searches of Algorithm traced to a file, see replay
+	std::unique_ptr<Trace> trace;
+	if (const char *path = std::getenv("HAPPY_CUBE_TRACE")) {
+		trace = std::make_unique<Trace>(path);
+		if (!trace->good()) {
+			std::cerr << "cannot write " << path << std::endl;
+			return 1;
+		}
+	}
+
+	if (argc > 1 && std::string("generate") == argv[1])
+		return generate(argc - 1, argv + 1);
+	if (argc > 1 && std::string("partial") == argv[1])
+		return partial(argc - 1, argv + 1);
+	if (argc > 1 && std::string("pool") == argv[1])
+		return pool(argc - 1, argv + 1);
+	if (argc > 1 && std::string("complete") == argv[1])
+		return complete(argc - 1, argv + 1);
+	if (argc > 1 && std::string("census") == argv[1])
+		return census(argc - 1, argv + 1);
+	if (argc > 1 && std::string("solve") == argv[1])
+		return solve(argc - 1, argv + 1);
+	if (argc > 1 && std::string("lockstep") == argv[1])
+		return lockstep(argc - 1, argv + 1);
+	if (argc > 1 && std::string("near") == argv[1])
+		return near(argc - 1, argv + 1);
+
+	// for (const Brick& b: happy_cube::catalogue())
 	// 	std::cout << b << std::endl;
 
 	// 'Watt' from the paper
@@ -33,6 +90,8 @@ main(int argc, char *argv[]) {
 	// const Brick b5(std::vector<unsigned int>{      2, 3, 4,    6,    8, 9,         12, 13        });
 	// const Brick b6(std::vector<unsigned int>{0, 1,          5,    7, 8, 9,         12, 13    , 15});
 
+	Allocations::enable(true);
+
 	// 'red' from the game
 	const Brick b1(std::vector<unsigned int>{0, 1,    3, 4,       7, 8, 9,     11,             15});
 	const Brick b2(std::vector<unsigned int>{      2, 3, 4, 5,    7, 8,    10, 11, 12,     14    });
@@ -48,39 +107,283 @@ main(int argc, char *argv[]) {
 	std::cout << b4 << std::endl;
 	std::cout << b5 << std::endl;
 	std::cout << b6 << std::endl;
-	Solution s = Solution::assemble(b1, b2, b3, b4, b5, b6);
+	Control control;
+	Solution s = Solution::assemble(b1, b2, b3, b4, b5, b6, control);
 
 	std::cout << std::endl << "Output:" << std::endl;
 	for (const BrickB& b: s)
 		std::cout << b << std::endl;
 
+	if (Allocations::available()) {
+		std::cout << std::endl << "Allocations:" << std::endl;
+		Allocations::Counts c = control.stats().allocations;
+		c[Allocations::bricks] = Allocations::counts()[Allocations::bricks];
+		for (unsigned int p = 0; p < Allocations::phases; ++p)
+			std::cout << Allocations::name(Allocations::Phase(p)) << ": "
+				  << c[p].allocations << " (" << c[p].bytes << " bytes)"
+				  << std::endl;
+	}
+
 	return 0;
 }
 
-static std::vector<Brick>
-generate_bricks() {
-	typedef std::set<BrickB> BricksSet;
-	BricksSet aux;
-	for (unsigned int i = 1; i < 16; ++i) {
-		utils::Combinations c(16, i);
-		for (const auto& x: c) {
-			BrickB b(x.elements());
-			if (b.valid()) {
-				BricksSet::iterator e = aux.end();
-				unsigned int k = 0;
-				for (; k < 8; ++k)
-					if (e != aux.find(b.t(k)))
-						break;
-				if (8 == k)
-					aux.emplace(std::move(b));
-			}
+// generate <count> [<threads> [<seed>]]
+static int
+generate(int argc, char *argv[]) {
+	if (argc < 2) {
+		std::cerr << "usage: happy_cube generate <count> [<threads> [<seed>]]"
+			  << std::endl;
+		return 1;
+	}
+	std::size_t n = std::strtoul(argv[1], nullptr, 10);
+	unsigned int threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) :
+		std::max(1u, std::thread::hardware_concurrency());
+	std::uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) :
+		std::random_device()();
+
+	for (const Puzzle& p: happy_cube::generate(n, threads, seed))
+		std::cout << p << '\n';
+	std::cout.flush();
+
+	return 0;
+}
+
+// partial [joints|bricks] < puzzles
+static int
+partial(int argc, char *argv[]) {
+	Partial::Objective objective = Partial::joints;
+	if (argc > 1 && std::string("bricks") == argv[1])
+		objective = Partial::bricks;
+
+	Puzzle p;
+	while (std::cin >> p) {
+		std::vector<std::reference_wrapper<const Brick> > b(p.bricks());
+		Partial r = Partial::assemble(b[0], b[1], b[2], b[3], b[4], b[5],
+					      objective);
+		std::cout << p << std::endl << r << std::endl;
+	}
+
+	return 0;
+}
+
+// pool [all] < brick codes
+static int
+pool(int argc, char *argv[]) {
+	bool all = argc > 1 && std::string("all") == argv[1];
+
+	std::vector<Brick> bricks;
+	unsigned int c;
+	while (std::cin >> std::hex >> c)
+		bricks.emplace_back(BrickB::from_code(c));
+	Pool p(std::move(bricks));
+
+	std::function<bool(const happy_cube::Cube&)> print =
+		[&p, all](const happy_cube::Cube& cube) {
+			Puzzle s;
+			for (unsigned int i = 0; i < cube.size(); ++i)
+				s[i] = p.brick(cube[i].brick).brick(cube[i].orientation).code();
+			std::cout << s << std::endl;
+			return all;
+		};
+	if (0 == p.enumerate(print)) {
+		std::cerr << "no cube" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+// complete < brick codes, one or two short of a cube
+static int
+complete(int, char *[]) {
+	std::vector<Brick> bricks;
+	unsigned int c;
+	while (std::cin >> std::hex >> c)
+		bricks.emplace_back(BrickB::from_code(c));
+	const happy_cube::Surface& cube = happy_cube::Surface::cube();
+	if (bricks.size() + 2 < cube.faces().size() || bricks.size() >= cube.faces().size()) {
+		std::cerr << "usage: complete < brick codes, one or two short of a cube"
+			  << std::endl;
+		return 1;
+	}
+
+	std::vector<std::vector<std::uint16_t> > found(happy_cube::complete(cube, bricks));
+	if (found.empty()) {
+		std::cerr << "no completion" << std::endl;
+		return 1;
+	}
+	std::cout << std::hex << std::setfill('0');
+	for (const std::vector<std::uint16_t>& v: found) {
+		for (std::size_t i = 0; i < v.size(); ++i)
+			std::cout << (0 == i ? "" : " ") << std::setw(4) << v[i];
+		std::cout << std::endl;
+	}
+
+	return 0;
+}
+
+// census plan <dir> <shards> < brick codes
+// census work <dir> [<stale seconds> [<checkpoint seconds>]]
+// census merge <dir>
+static int
+census(int argc, char *argv[]) {
+	std::string command = argc > 1 ? argv[1] : "";
+	if (argc < 3 || (command != "plan" && command != "work" && command != "merge") ||
+	    (command == "plan" && argc < 4)) {
+		std::cerr << "usage: happy_cube census plan <dir> <shards> < brick codes"
+			  << std::endl
+			  << "       happy_cube census work <dir> [<stale seconds> [<checkpoint seconds>]]"
+			  << std::endl
+			  << "       happy_cube census merge <dir>" << std::endl;
+		return 1;
+	}
+	std::string dir = argv[2];
+
+	if (command == "plan") {
+		std::vector<std::uint16_t> codes;
+		unsigned int c;
+		while (std::cin >> std::hex >> c)
+			codes.push_back(c);
+		if (!Census::plan(dir, codes, std::strtoul(argv[3], nullptr, 10))) {
+			std::cerr << "cannot write the manifest in " << dir << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+
+	Census c;
+	if (!c.open(dir)) {
+		std::cerr << "no valid manifest in " << dir << std::endl;
+		return 1;
+	}
+	if (command == "work") {
+		unsigned int stale = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 0;
+		unsigned int interval = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 60;
+		std::cerr << c.work(stale, interval) << " of " << c.shards()
+			  << " shards completed" << std::endl;
+		return 0;
+	}
+
+	Census::Counts total;
+	if (!c.merge(std::cout, total)) {
+		std::cerr << "not all the shards are done" << std::endl;
+		return 1;
+	}
+	std::cerr << total.unsolvable << " unsolvable, " << total.unique << " unique, "
+		  << total.multiple << " with several assemblies; "
+		  << total.rejected << " rejected by the prefilter ("
+		  << 100.0 * total.rejected / std::max<std::uint64_t>(1, total.unsolvable + total.unique + total.multiple) << "%)"
+		  << std::endl;
+	return 0;
+}
+
+// solve [<threads> [<metrics seconds>]] < puzzles
+static int
+solve(int argc, char *argv[]) {
+	typedef happy_cube::Metrics Metrics;
+	unsigned int threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) :
+		std::max(1u, std::thread::hardware_concurrency());
+	unsigned int every = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0;
+	if (0 == threads) {
+		std::cerr << "usage: happy_cube solve [<threads> [<metrics seconds>]] < puzzles,"
+			  << " with at least one thread" << std::endl;
+		return 1;
+	}
+
+	// dumps the metrics on stderr every so many seconds, and at the end
+	Metrics metrics;
+	Metrics::Recorder& recorder = metrics.recorder();
+	std::mutex mutex;
+	std::condition_variable finished;
+	bool done = false;
+	std::thread dumper;
+	if (0 != every)
+		dumper = std::thread([&]() {
+			std::unique_lock<std::mutex> lock(mutex);
+			while (!finished.wait_for(lock, std::chrono::seconds(every),
+						  [&done]() { return done; }))
+				metrics.dump(std::cerr);
+		});
+
+	std::vector<Puzzle> puzzles;
+	for (;;) {
+		Metrics::Clock::time_point t = Metrics::Clock::now();
+		Puzzle p;
+		if (!(std::cin >> p))
+			break;
+		puzzles.push_back(p);
+		recorder.record(Metrics::parse, Metrics::Clock::now() - t);
+	}
+	std::vector<Solution> solutions(happy_cube::solve(puzzles, threads,
+							  0 != every ? &metrics : nullptr));
+
+	for (std::size_t i = 0; i < puzzles.size(); ++i) {
+		Metrics::Clock::time_point t = Metrics::Clock::now();
+		std::cout << puzzles[i] << std::endl;
+		if (solutions[i].empty())
+			std::cout << "no cube" << std::endl;
+		else {
+			Puzzle a;
+			for (unsigned int f = 0; f < a.size(); ++f)
+				a[f] = solutions[i][f].get().code();
+			std::cout << a << std::endl;
+		}
+		recorder.record(Metrics::output, Metrics::Clock::now() - t);
+	}
+
+	if (0 != every) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			done = true;
 		}
+		finished.notify_one();
+		dumper.join();
+		metrics.dump(std::cerr);
 	}
 
-	typedef std::vector<Brick> Bricks;
-	Bricks bricks;
-	std::move(aux.begin(), aux.end(), std::back_inserter(bricks));
-	std::sort(bricks.begin(), bricks.end());
+	return 0;
+}
+
+// lockstep < puzzles, the output of solve, with maybe other assemblies
+static int
+lockstep(int, char *[]) {
+	std::vector<Puzzle> puzzles;
+	for (Puzzle p; std::cin >> p;)
+		puzzles.push_back(p);
+	std::vector<happy_cube::Cube> cubes;
+	std::vector<char> found(happy_cube::lockstep(puzzles, cubes));
 
-	return bricks;
+	for (std::size_t i = 0; i < puzzles.size(); ++i) {
+		std::cout << puzzles[i] << std::endl;
+		if (!found[i]) {
+			std::cout << "no cube" << std::endl;
+			continue;
+		}
+		Puzzle a;
+		for (unsigned int f = 0; f < a.size(); ++f) {
+			const happy_cube::Pick& x = cubes[i][f];
+			a[f] = happy_cube::intern(puzzles[i][x.brick]).brick(x.orientation).code();
+		}
+		std::cout << a << std::endl;
+	}
+	return 0;
+}
+
+// near [<distance>] < puzzles, and for each one the bricks within distance
+// of one of its bricks that make it uniquely solvable in its place: the
+// index of that brick, the code and the distance
+static int
+near(int argc, char *argv[]) {
+	unsigned int distance = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2;
+	const happy_cube::Neighbours neighbours;
+	const std::vector<Brick>& catalogue = happy_cube::catalogue();
+	for (Puzzle p; std::cin >> p;) {
+		std::cout << p << std::endl;
+		for (unsigned int i = 0; i < p.size(); ++i)
+			for (const happy_cube::Neighbours::Near& n: neighbours.fixes(p, i, distance))
+				std::cout << i << ' ' << std::hex << std::setfill('0') << std::setw(4)
+					  << catalogue[n.brick].brick(0).code() << std::dec << ' '
+					  << n.distance << std::endl;
+	}
+	return 0;
 }
@@ -0,0 +1,122 @@
+#include "metrics.hh"
+#include <algorithm>
+#include <utility>
+
+namespace happy_cube {
+
+Histogram::Histogram() noexcept
+	: counts{}
+{
+}
+
+void
+Histogram::add(const Histogram& other) noexcept {
+	for (unsigned int i = 0; i < buckets; ++i)
+		counts[i].fetch_add(other.counts[i].load(std::memory_order_relaxed),
+				    std::memory_order_relaxed);
+}
+
+std::uint64_t
+Histogram::count() const noexcept {
+	std::uint64_t r = 0;
+	for (const std::atomic<std::uint64_t>& c: counts)
+		r += c.load(std::memory_order_relaxed);
+	return r;
+}
+
+std::uint64_t
+Histogram::value(unsigned int i) noexcept {
+	if (i < 32)
+		return i;
+	unsigned int msb = i / 16 + 3;
+	return (std::uint64_t(i % 16 + 17) << (msb - 4)) - 1;
+}
+
+std::uint64_t
+Histogram::quantile(double q) const noexcept {
+	std::uint64_t n = count();
+	if (0 == n)
+		return 0;
+	std::uint64_t rank = std::min<std::uint64_t>(n - 1, q * n), seen = 0;
+	for (unsigned int i = 0; i < buckets; ++i) {
+		seen += counts[i].load(std::memory_order_relaxed);
+		if (seen > rank)
+			return value(i);
+	}
+	return value(buckets - 1);
+}
+
+Metrics::Recorder::Recorder() noexcept
+	: puzzles(0)
+	, solutions(0)
+	, nodes(0)
+	, next(nullptr)
+{
+}
+
+Metrics::Metrics()
+	: recorders(nullptr)
+	, start(Clock::now())
+{
+}
+
+Metrics::~Metrics() {
+	for (Recorder *r = recorders.load(); r;) {
+		Recorder *next = r->next;
+		delete r;
+		r = next;
+	}
+}
+
+Metrics::Recorder&
+Metrics::recorder() {
+	Recorder *r = new Recorder;
+	r->next = recorders.load(std::memory_order_relaxed);
+	while (!recorders.compare_exchange_weak(r->next, r, std::memory_order_release,
+						std::memory_order_relaxed))
+		;
+	return *r;
+}
+
+const char *
+Metrics::name(Phase p) noexcept {
+	static const char *const names[phases] = {
+		"parse", "setup", "search", "output",
+	};
+	return names[p];
+}
+
+void
+Metrics::dump(std::ostream& os) const {
+	// the counts of all the recorders, merged into one
+	std::array<Histogram, phases> latencies;
+	std::uint64_t puzzles = 0, solutions = 0, nodes = 0;
+	for (const Recorder *r = recorders.load(std::memory_order_acquire); r; r = r->next) {
+		for (unsigned int p = 0; p < phases; ++p)
+			latencies[p].add(r->latencies[p]);
+		puzzles += r->puzzles.load(std::memory_order_relaxed);
+		solutions += r->solutions.load(std::memory_order_relaxed);
+		nodes += r->nodes.load(std::memory_order_relaxed);
+	}
+	double t = std::chrono::duration<double>(Clock::now() - start).count();
+
+	os << "{\"seconds\":" << t;
+	const std::pair<const char *, std::uint64_t> counters[] = {
+		{"puzzles", puzzles},
+		{"solutions", solutions},
+		{"nodes", nodes},
+	};
+	for (const auto& c: counters)
+		os << ",\"" << c.first << "\":" << c.second
+		   << ",\"" << c.first << "_per_second\":" << (t > 0 ? c.second / t : 0);
+	for (unsigned int p = 0; p < phases; ++p) {
+		const Histogram& h = latencies[p];
+		os << ",\"" << name(Phase(p)) << "\":{\"count\":" << h.count()
+		   << ",\"p50\":" << h.quantile(0.5) << ",\"p90\":" << h.quantile(0.9)
+		   << ",\"p99\":" << h.quantile(0.99) << ",\"p999\":" << h.quantile(0.999)
+		   << ",\"max\":" << h.quantile(1) << '}';
+	}
+	os << '}' << std::endl;
+}
+
+}
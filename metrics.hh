@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace happy_cube {
+
+// A histogram of durations in nanoseconds, in buckets of 1/16 of a power
+// of two, so that every value is known within about 6%. It is written by one
+// thread and read by any, without locks.
+class Histogram {
+public:
+	static constexpr unsigned int buckets = 60 * 16;
+
+private:
+	std::array<std::atomic<std::uint64_t>, buckets> counts;
+
+public:
+	Histogram() noexcept;
+
+	void record(std::uint64_t) noexcept;
+	// adds the counts of another histogram, as they are at the moment
+	void add(const Histogram&) noexcept;
+
+	std::uint64_t count() const noexcept;
+	// the least value above the share q of the values, bounded by a bucket
+	std::uint64_t quantile(double q) const noexcept;
+
+	static unsigned int bucket(std::uint64_t) noexcept;
+	// the upper bound of the values of a bucket
+	static std::uint64_t value(unsigned int) noexcept;
+};
+
+// The latencies and the throughput of solving puzzles, recorded by each
+// thread into its own recorder and merged when dumped.
+class Metrics {
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	enum Phase {
+		parse,
+		setup,
+		search,
+		output,
+		phases,
+	};
+
+	class Recorder {
+	private:
+		std::array<Histogram, phases> latencies;
+		std::atomic<std::uint64_t> puzzles, solutions, nodes;
+		Recorder *next;
+
+	friend class Metrics;
+
+	public:
+		Recorder() noexcept;
+
+		void record(Phase, Clock::duration) noexcept;
+		// puzzles solved, the solutions found and the nodes searched
+		void count(std::uint64_t puzzles, std::uint64_t solutions,
+			   std::uint64_t nodes) noexcept;
+	};
+
+private:
+	std::atomic<Recorder *> recorders;
+	Clock::time_point start;
+
+public:
+	Metrics();
+	Metrics(const Metrics&) = delete;
+	~Metrics();
+
+	// a new recorder, for the calling thread, kept up to the end
+	Recorder& recorder();
+
+	// Writes a line of JSON: the seconds since the start, the counts and
+	// their rates per second, and the quantiles of the latencies in
+	// nanoseconds of every phase.
+	void dump(std::ostream&) const;
+
+	static const char *name(Phase) noexcept;
+};
+
+inline unsigned int
+Histogram::bucket(std::uint64_t v) noexcept {
+	if (v < 32)
+		return v;
+	unsigned int msb = 63 - __builtin_clzll(v);
+	return (msb - 4) * 16 + (v >> (msb - 4));
+}
+
+inline void
+Histogram::record(std::uint64_t v) noexcept {
+	// the only writer
+	std::atomic<std::uint64_t>& c = counts[std::min(bucket(v), buckets - 1)];
+	c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+inline void
+Metrics::Recorder::record(Phase p, Clock::duration d) noexcept {
+	latencies[p].record(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+}
+
+inline void
+Metrics::Recorder::count(std::uint64_t p, std::uint64_t s, std::uint64_t n) noexcept {
+	puzzles.store(puzzles.load(std::memory_order_relaxed) + p, std::memory_order_relaxed);
+	solutions.store(solutions.load(std::memory_order_relaxed) + s, std::memory_order_relaxed);
+	nodes.store(nodes.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+}
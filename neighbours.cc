@@ -0,0 +1,89 @@
+#include "neighbours.hh"
+#include "catalogue.hh"
+#include "assemble.hh"
+#include <algorithm>
+
+namespace happy_cube {
+
+Neighbours::Neighbours()
+	: splits{{{{0, 8, 16}, {}, {}}, {{0, 6, 11, 16}, {}, {}}}}
+{
+	const std::vector<Brick>& bricks = catalogue();
+	for (Split& split: splits)
+		for (unsigned int p = 0; p + 1 < split.bounds.size(); ++p) {
+			unsigned int first = split.bounds[p];
+			unsigned int width = split.bounds[p + 1] - first;
+			auto part = [first, width](std::uint16_t c) {
+				return c >> first & ((1u << width) - 1);
+			};
+			std::vector<unsigned int> s((1u << width) + 1, 0);
+			for (const Brick& b: bricks)
+				for (unsigned int o = 0; o < b.degree(); ++o)
+					++s[part(b.brick(o).code()) + 1];
+			for (unsigned int v = 0; v < 1u << width; ++v)
+				s[v + 1] += s[v];
+
+			std::vector<unsigned int> next(s.begin(), s.end() - 1);
+			std::vector<std::uint32_t> e(s.back());
+			for (unsigned int i = 0; i < bricks.size(); ++i)
+				for (unsigned int o = 0; o < bricks[i].degree(); ++o) {
+					std::uint16_t c = bricks[i].brick(o).code();
+					e[next[part(c)]++] = c | i << 16;
+				}
+			split.entries.push_back(std::move(e));
+			split.start.push_back(std::move(s));
+		}
+}
+
+std::vector<Neighbours::Near>
+Neighbours::near(std::uint16_t code, unsigned int distance) const {
+	std::vector<Near> r;
+	auto check = [&r, code, distance](const std::uint32_t *e, const std::uint32_t *end) {
+		for (; end != e; ++e) {
+			unsigned int d = __builtin_popcount((*e ^ code) & 0xffff);
+			if (d <= distance)
+				r.push_back(Near{*e >> 16, d});
+		}
+	};
+	if (0 == distance)
+		return r;
+	if (distance < 1 + splits.size()) {
+		const Split& split = splits[distance - 1];
+		for (unsigned int p = 0; p < split.entries.size(); ++p) {
+			unsigned int first = split.bounds[p];
+			unsigned int v = code >> first & ((1u << (split.bounds[p + 1] - first)) - 1);
+			const std::uint32_t *e = split.entries[p].data();
+			check(e + split.start[p][v], e + split.start[p][v + 1]);
+		}
+	} else {
+		const std::vector<std::uint32_t>& all = splits[0].entries[0];
+		check(all.data(), all.data() + all.size());
+	}
+
+	// the least distance of every brick, leaving out the brick itself
+	std::sort(r.begin(), r.end(), [](const Near& a, const Near& b) {
+		return a.brick < b.brick || (a.brick == b.brick && a.distance < b.distance);
+	});
+	r.erase(std::unique(r.begin(), r.end(), [](const Near& a, const Near& b) {
+		return a.brick == b.brick;
+	}), r.end());
+	r.erase(std::remove_if(r.begin(), r.end(), [](const Near& n) {
+		return 0 == n.distance;
+	}), r.end());
+	return r;
+}
+
+std::vector<Neighbours::Near>
+Neighbours::fixes(const Puzzle& puzzle, unsigned int i, unsigned int distance) const {
+	std::vector<Near> r;
+	for (const Near& n: near(puzzle[i], distance)) {
+		Puzzle p(puzzle);
+		p[i] = catalogue()[n.brick].brick(0).code();
+		std::vector<std::reference_wrapper<const Brick> > b(p.bricks());
+		if (1 == Solution::count(b[0], b[1], b[2], b[3], b[4], b[5], 2))
+			r.push_back(n);
+	}
+	return r;
+}
+
+}
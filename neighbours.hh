@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include "brick.hh"
+#include "puzzle.hh"
+
+namespace happy_cube {
+
+// The bricks of the catalogue within a few perimeter cells toggled of a
+// brick, in any orientation, e.g. to mend an ambiguous puzzle. The codes of
+// every orientation of the catalogue bricks are indexed by multi-index
+// hashing: the 16 bits are split into d + 1 parts, and every code is filed
+// under each of its parts. A code within distance d of another one has a
+// part equal to the same part of the other, so a query looks up its own
+// parts and checks the codes found by popcount. Up to distance 2; past it
+// the buckets are so large that all the codes are checked.
+class Neighbours {
+public:
+	struct Near {
+		// an index in catalogue()
+		unsigned int brick;
+		// the least number of cells toggled over the orientations
+		unsigned int distance;
+	};
+
+private:
+	// the codes split into parts, those whose part p has value v in
+	// [start[p][v], start[p][v + 1]) of entries[p], as code | brick << 16
+	struct Split {
+		// the first bit of each part, and the end of the last one
+		std::vector<unsigned int> bounds;
+		std::vector<std::vector<std::uint32_t> > entries;
+		std::vector<std::vector<unsigned int> > start;
+	};
+
+	// into 2 and 3 parts
+	std::array<Split, 2> splits;
+
+public:
+	Neighbours();
+
+	// The bricks within distance of the brick of code, other than that
+	// brick, by catalogue index.
+	std::vector<Near> near(std::uint16_t code, unsigned int distance) const;
+	// those of the bricks within distance of brick i of the puzzle that
+	// make it uniquely solvable in its place, up to symmetries and equal
+	// bricks as in Solution::count
+	std::vector<Near> fixes(const Puzzle&, unsigned int i, unsigned int distance) const;
+};
+
+}
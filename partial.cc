@@ -0,0 +1,334 @@
+#include "partial.hh"
+#include "surface.hh"
+#include <algorithm>
+
+namespace happy_cube {
+
+namespace {
+
+// junctions that close together: the three middle cells of an edge or a
+// corner
+struct Joint {
+	std::vector<const Junction *> junctions;
+	// the faces involved
+	unsigned int faces;
+	// in Surface::edges or in Surface::corners
+	bool edge;
+	unsigned int index;
+};
+
+// whether every junction of a joint has one cell filled
+bool
+closes(const Joint& j, const std::vector<std::uint16_t>& code) noexcept {
+	for (const Junction *junction: j.junctions) {
+		unsigned int filled = 0;
+		for (const Cell& c: *junction)
+			filled += code[c.face] >> c.cell & 1;
+		if (1 != filled)
+			return false;
+	}
+	return true;
+}
+
+// whether the bricks on faces fill a cell of a junction of a joint twice
+bool
+clashes(const Joint& j, const std::vector<std::uint16_t>& code, unsigned int faces) noexcept {
+	for (const Junction *junction: j.junctions) {
+		unsigned int filled = 0;
+		for (const Cell& c: *junction)
+			if (0 != (faces >> c.face & 1))
+				filled += code[c.face] >> c.cell & 1;
+		if (filled > 1)
+			return true;
+	}
+	return false;
+}
+
+}
+
+class BranchAndBound {
+private:
+	static constexpr unsigned int empty = ~0u;
+
+	const std::vector<const Brick *>& bricks;
+	Partial::Objective objective;
+	unsigned int n;
+
+	std::vector<Joint> joints;
+	// the joints whose last face, in the order of placing, is a face
+	std::vector<std::vector<unsigned int> > closing;
+	// the joints of each face
+	std::vector<std::vector<unsigned int> > touching;
+	// pending[d][f], f >= d, are the joints of f whose other faces are
+	// placed before d
+	std::vector<std::vector<std::vector<unsigned int> > > pending;
+	// the number of joints with at least two faces placed from d on
+	std::vector<unsigned int> open;
+
+	// the current assembly, the brick and orientation on each face
+	std::vector<unsigned int> brick, orientation;
+	std::vector<std::uint16_t> code;
+	unsigned int used, placed;
+
+	// the best assembly so far
+	std::vector<unsigned int> best_brick, best_orientation;
+	unsigned int best, max;
+
+public:
+	BranchAndBound(const std::vector<const Brick *>&, Partial::Objective);
+
+	void search(unsigned int d, unsigned int score);
+	Partial result() const;
+
+private:
+	unsigned int gain(unsigned int d) const noexcept;
+	unsigned int bound(unsigned int d, unsigned int score);
+	bool usable(unsigned int b) const noexcept;
+};
+
+BranchAndBound::BranchAndBound(const std::vector<const Brick *>& bricks__,
+			       Partial::Objective objective__)
+	: bricks(bricks__)
+	, objective(objective__)
+	, n(Surface::cube().faces().size())
+	, closing(n)
+	, touching(n)
+	, pending(n + 1, std::vector<std::vector<unsigned int> >(n))
+	, open(n + 1, 0)
+	, brick(n, empty)
+	, orientation(n, 0)
+	, code(n, 0)
+	, used(0)
+	, placed(0)
+	, best(0)
+{
+	const Surface& surface = Surface::cube();
+	for (unsigned int i = 0; i < surface.edges().size(); ++i) {
+		const Edge& e = surface.edges()[i];
+		Joint j{{}, 1u << e.a | 1u << e.b, true, i};
+		for (unsigned int k: e.junctions)
+			j.junctions.push_back(&surface.junctions()[k]);
+		joints.push_back(std::move(j));
+	}
+	for (unsigned int i = 0; i < surface.corners().size(); ++i) {
+		const Junction& c = surface.junctions()[surface.corners()[i]];
+		Joint j{{&c}, 0, false, i};
+		for (const Cell& e: c)
+			j.faces |= 1u << e.face;
+		joints.push_back(std::move(j));
+	}
+
+	for (unsigned int i = 0; i < joints.size(); ++i) {
+		unsigned int faces = joints[i].faces;
+		closing[31 - __builtin_clz(faces)].push_back(i);
+		for (unsigned int f = 0; f < n; ++f)
+			if (0 != (faces >> f & 1))
+				touching[f].push_back(i);
+		for (unsigned int d = 0; d <= n; ++d) {
+			unsigned int later = faces >> d << d;
+			if (__builtin_popcount(later) > 1)
+				++open[d];
+			else if (0 != later)
+				pending[d][__builtin_ctz(later)].push_back(i);
+		}
+	}
+
+	max = objective == Partial::joints ? joints.size() : n;
+}
+
+// the number of joints closed by placing the brick on face d; placing
+// bricks, 1, or empty if a joint of the face does not close or, next to an
+// empty face, has a cell filled twice
+unsigned int
+BranchAndBound::gain(unsigned int d) const noexcept {
+	if (objective == Partial::bricks) {
+		for (unsigned int i: touching[d]) {
+			const Joint& j = joints[i];
+			bool all = (j.faces & placed) == j.faces;
+			if (all ? !closes(j, code) : clashes(j, code, placed))
+				return empty;
+		}
+		return 1;
+	}
+	unsigned int r = 0;
+	for (unsigned int i: closing[d])
+		if (closes(joints[i], code))
+			++r;
+	return r;
+}
+
+// an upper bound of the score of the assemblies completing the current one
+// from face d on
+unsigned int
+BranchAndBound::bound(unsigned int d, unsigned int score) {
+	unsigned int fillable = 0, sum = 0;
+	for (unsigned int f = d; f < n; ++f) {
+		// the most joints with the bricks already placed that any
+		// remaining brick can close on f, the remaining bricks being
+		// free to repeat
+		unsigned int most = 0;
+		bool fits = false;
+		for (unsigned int b = 0; b < bricks.size(); ++b) {
+			if (!usable(b))
+				continue;
+			if (fits && most == pending[d][f].size())
+				break;
+			for (unsigned int o = 0; o < bricks[b]->degree(); ++o) {
+				code[f] = bricks[b]->brick(o).code();
+				unsigned int closed = 0;
+				bool all = true;
+				for (unsigned int i: pending[d][f]) {
+					unsigned int others = joints[i].faces & ~(1u << f);
+					if ((others & placed) != others)
+						// next to an empty face
+						all = all && !clashes(joints[i], code, placed | 1u << f);
+					else if (closes(joints[i], code))
+						++closed;
+					else
+						all = false;
+				}
+				most = std::max(most, closed);
+				fits = fits || all;
+			}
+		}
+		sum += most;
+		if (fits)
+			++fillable;
+	}
+
+	if (objective == Partial::joints)
+		return score + sum + open[d];
+	unsigned int left = bricks.size() - __builtin_popcount(used);
+	return score + std::min(left, fillable);
+}
+
+// equal bricks are placed in the order of their indices
+bool
+BranchAndBound::usable(unsigned int b) const noexcept {
+	return !(used & 1u << b) &&
+		!(b > 0 && !(used & 1u << (b - 1)) && *bricks[b] == *bricks[b - 1]);
+}
+
+void
+BranchAndBound::search(unsigned int d, unsigned int score) {
+	if (best == max)
+		return;
+	if (n == d) {
+		if (score > best || best_brick.empty()) {
+			best = score;
+			best_brick = brick;
+			best_orientation = orientation;
+		}
+		return;
+	}
+	if (!best_brick.empty() && bound(d, score) <= best)
+		return;
+
+	for (unsigned int b = 0; b < bricks.size(); ++b) {
+		if (!usable(b))
+			continue;
+		// the foundation is in its initial orientation, with all bricks
+		// placed it is the first brick
+		unsigned int degree = 0 == d ? 1 : bricks[b]->degree();
+		for (unsigned int o = 0; o < degree; ++o) {
+			brick[d] = b;
+			orientation[d] = o;
+			code[d] = bricks[b]->brick(o).code();
+			used |= 1u << b;
+			placed |= 1u << d;
+			unsigned int g = gain(d);
+			if (empty != g)
+				search(d + 1, score + g);
+			used &= ~(1u << b);
+			placed &= ~(1u << d);
+		}
+		if (0 == d && objective == Partial::joints)
+			break;
+	}
+
+	if (d > 0 && objective == Partial::bricks) {
+		brick[d] = empty;
+		search(d + 1, score);
+	}
+	brick[d] = empty;
+}
+
+Partial
+BranchAndBound::result() const {
+	Partial r;
+	r.faces_.resize(n, nullptr);
+	for (unsigned int f = 0; f < n; ++f)
+		if (empty != best_brick[f])
+			r.faces_[f] = &bricks[best_brick[f]]->brick(best_orientation[f]);
+
+	// a joint next to an empty face breaks if it has a cell filled twice
+	unsigned int placed = 0;
+	std::vector<std::uint16_t> code(n, 0);
+	for (unsigned int f = 0; f < n; ++f)
+		if (nullptr != r.faces_[f]) {
+			placed |= 1u << f;
+			code[f] = r.faces_[f]->code();
+		}
+	for (const Joint& j: joints) {
+		bool all = (j.faces & placed) == j.faces;
+		if (all ? !closes(j, code) : clashes(j, code, placed))
+			(j.edge ? r.edges_ : r.corners_).push_back(j.index);
+	}
+	return r;
+}
+
+Partial
+Partial::assemble(const Brick& b1, const Brick& b2, const Brick& b3,
+		  const Brick& b4, const Brick& b5, const Brick& b6,
+		  Objective objective) {
+	std::vector<const Brick *> bricks{&b1, &b2, &b3, &b4, &b5, &b6};
+	std::sort(bricks.begin(), bricks.end(),
+		  [](const Brick *b1, const Brick *b2) {
+			  return *b1 < *b2;
+		  });
+
+	BranchAndBound bb(bricks, objective);
+	bb.search(0, 0);
+	return bb.result();
+}
+
+unsigned int
+Partial::placed() const noexcept {
+	return std::count_if(faces_.begin(), faces_.end(),
+			     [](const BrickB *b) {
+				     return nullptr != b;
+			     });
+}
+
+static const char *const names[] = {
+	"foundation", "top", "right", "bottom", "left", "lid",
+};
+
+std::ostream&
+operator<<(std::ostream& os, const Partial& p) {
+	const Surface& surface = Surface::cube();
+	for (unsigned int f = 0; f < p.faces().size(); ++f) {
+		os << names[f] << ": ";
+		if (const BrickB *b = p.faces()[f])
+			os << '(' << b->top() << ", " << b->right() << ", "
+			   << b->bottom() << ", " << b->left() << ')';
+		else
+			os << "empty";
+		os << std::endl;
+	}
+	for (unsigned int e: p.broken_edges())
+		os << "broken edge " << names[surface.edges()[e].a] << '/'
+		   << names[surface.edges()[e].b] << std::endl;
+	for (unsigned int c: p.broken_corners()) {
+		os << "broken corner";
+		char sep = ' ';
+		for (const Cell& e: surface.junctions()[surface.corners()[c]]) {
+			os << sep << names[e.face];
+			sep = '/';
+		}
+		os << std::endl;
+	}
+	return os;
+}
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include <ostream>
+#include "brick.hh"
+
+namespace happy_cube {
+
+// The best assembly of six bricks that do not necessarily build a cube,
+// laid on the faces of Surface::cube().
+class Partial {
+public:
+	enum Objective {
+		// all bricks are placed, as many edges and corners as possible
+		// are closed
+		joints,
+		// as many bricks as possible are placed, all the edges and
+		// corners between them being closed
+		bricks,
+	};
+
+private:
+	// the brick on each face, nullptr for an empty face
+	std::vector<const BrickB *> faces_;
+	// the edges (in Surface::edges) and the corners (in
+	// Surface::corners) between placed bricks that do not close
+	std::vector<unsigned int> edges_, corners_;
+
+friend class BranchAndBound;
+
+public:
+	static Partial assemble(const Brick& b1, const Brick& b2, const Brick& b3,
+				const Brick& b4, const Brick& b5, const Brick& b6,
+				Objective);
+
+	const std::vector<const BrickB *>& faces() const noexcept;
+	const std::vector<unsigned int>& broken_edges() const noexcept;
+	const std::vector<unsigned int>& broken_corners() const noexcept;
+
+	unsigned int placed() const noexcept;
+	bool complete() const noexcept;
+};
+
+inline const std::vector<const BrickB *>&
+Partial::faces() const noexcept {
+	return faces_;
+}
+
+inline const std::vector<unsigned int>&
+Partial::broken_edges() const noexcept {
+	return edges_;
+}
+
+inline const std::vector<unsigned int>&
+Partial::broken_corners() const noexcept {
+	return corners_;
+}
+
+inline bool
+Partial::complete() const noexcept {
+	return edges_.empty() && corners_.empty() && placed() == faces_.size();
+}
+
+extern std::ostream& operator<<(std::ostream&, const Partial&);
+
+}
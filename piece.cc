@@ -0,0 +1,56 @@
+#include "piece.hh"
+#include <new>
+
+namespace happy_cube {
+
+void
+PieceTable::Free::operator()(unsigned char *p) const noexcept {
+	::operator delete(p, std::align_val_t(line));
+}
+
+// the size rounded up to whole cache lines
+static std::size_t
+lines(std::size_t n) {
+	return (n + PieceTable::line - 1) / PieceTable::line * PieceTable::line;
+}
+
+PieceTable::PieceTable(const std::vector<std::reference_wrapper<const Brick> >& b)
+	: size_(0)
+{
+	first.reserve(b.size() + 1);
+	for (const Brick& e: b) {
+		first.push_back(size_);
+		size_ += e.degree();
+	}
+	first.push_back(size_);
+	// the brick and orientation arrays are of bytes
+	assert(b.size() <= 256);
+
+	std::size_t bytes = lines(size_), words = lines(2 * size_);
+	storage.reset(static_cast<unsigned char *>(
+		::operator new(6 * bytes + words, std::align_val_t(line))));
+	std::uint8_t *s[4];
+	for (unsigned int n = 0; n < 4; ++n)
+		s[n] = storage.get() + n * bytes;
+	std::uint16_t *c = reinterpret_cast<std::uint16_t *>(storage.get() + 4 * bytes);
+	std::uint8_t *k = storage.get() + 4 * bytes + words,
+		*o = storage.get() + 5 * bytes + words;
+
+	for (unsigned int i = 0; i < b.size(); ++i)
+		for (unsigned int j = 0; j < b[i].get().degree(); ++j) {
+			unsigned int id = first[i] + j;
+			c[id] = b[i].get().brick(j).code();
+			for (unsigned int n = 0; n < 4; ++n)
+				s[n][id] = BrickB::side(c[id], n);
+			k[id] = i;
+			o[id] = j;
+		}
+
+	for (unsigned int n = 0; n < 4; ++n)
+		sides[n] = s[n];
+	codes = c;
+	bricks = k;
+	orientations = o;
+}
+
+}
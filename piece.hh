@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include "brick.hh"
+
+namespace happy_cube {
+
+// The orientations of several bricks laid out flat, e.g. those of the
+// bricks of a puzzle, built once and only read while searching. Each
+// orientation has a dense id, those of a brick being consecutive, and the
+// codes of its sides, of the whole brick, and the brick and orientation it
+// stands for are in separate arrays, each starting on a cache line.
+class PieceTable {
+public:
+	static const std::size_t line = 64;
+
+private:
+	struct Free {
+		void operator()(unsigned char *) const noexcept;
+	};
+
+	unsigned int size_;
+	// the id of the first orientation of each brick, the number of
+	// orientations at the end
+	std::vector<unsigned int> first;
+	std::unique_ptr<unsigned char, Free> storage;
+	const std::uint8_t *sides[4];
+	const std::uint16_t *codes;
+	const std::uint8_t *bricks, *orientations;
+
+public:
+	PieceTable(const std::vector<std::reference_wrapper<const Brick> >&);
+	PieceTable(const PieceTable&) = delete;
+	PieceTable& operator=(const PieceTable&) = delete;
+
+	unsigned int size() const noexcept;
+	unsigned int degree(unsigned int brick) const noexcept;
+	unsigned int id(unsigned int brick, unsigned int orientation) const noexcept;
+
+	// the code of side n of an orientation, 0 top, 1 right, 2 bottom,
+	// 3 left, as BrickB::side
+	unsigned int side(unsigned int id, unsigned int n) const noexcept;
+	std::uint16_t code(unsigned int id) const noexcept;
+	unsigned int brick(unsigned int id) const noexcept;
+	unsigned int orientation(unsigned int id) const noexcept;
+};
+
+inline unsigned int
+PieceTable::size() const noexcept {
+	return size_;
+}
+
+inline unsigned int
+PieceTable::degree(unsigned int brick) const noexcept {
+	return first[brick + 1] - first[brick];
+}
+
+inline unsigned int
+PieceTable::id(unsigned int brick, unsigned int orientation) const noexcept {
+	return first[brick] + orientation;
+}
+
+inline unsigned int
+PieceTable::side(unsigned int id, unsigned int n) const noexcept {
+	return sides[n][id];
+}
+
+inline std::uint16_t
+PieceTable::code(unsigned int id) const noexcept {
+	return codes[id];
+}
+
+inline unsigned int
+PieceTable::brick(unsigned int id) const noexcept {
+	return bricks[id];
+}
+
+inline unsigned int
+PieceTable::orientation(unsigned int id) const noexcept {
+	return orientations[id];
+}
+
+}
@@ -0,0 +1,162 @@
+#include "pool.hh"
+#include <algorithm>
+#include <set>
+
+namespace happy_cube {
+
+Pool::Pool(std::vector<Brick>&& bricks__)
+	: bricks(std::move(bricks__))
+	, index(bricks)
+{
+}
+
+// Places the bricks on the foundation, top, right, bottom, left, and lid.
+// The foundation is the brick of the least index in its initial
+// orientation, any cube can be turned to have it so. The candidates for a
+// side face are looked up by the code of the bottom side, that has to fit
+// the foundation, those of the lid by the code of the top side, that has
+// to fit the top brick, in SideIndex.
+class Pool::Search {
+private:
+	const Pool& pool;
+	const std::function<bool(const Cube&)>& visit;
+	Control *control;
+
+	Cube cube;
+	std::array<std::uint16_t, 6> code;
+	std::vector<char> used;
+
+	// the sets already visited
+	std::set<std::array<unsigned int, 6> > seen;
+	bool stop;
+
+public:
+	Search(const Pool&, const std::function<bool(const Cube&)>&, Control *);
+
+	unsigned long run();
+
+private:
+	void place(unsigned int slot);
+	bool fits(unsigned int slot, std::uint16_t) const noexcept;
+};
+
+Pool::Search::Search(const Pool& pool__,
+		     const std::function<bool(const Cube&)>& visit__,
+		     Control *control__)
+	: pool(pool__)
+	, visit(visit__)
+	, control(control__)
+	, used(pool.size(), 0)
+	, stop(false)
+{
+}
+
+unsigned long
+Pool::Search::run() {
+	for (unsigned int i = 0; i < pool.size() && !stop; ++i) {
+		if (control)
+			control->done(double(i) / pool.size());
+		cube[0] = Pick{i, 0};
+		code[0] = pool.brick(i).code();
+		used[i] = 1;
+		place(1);
+		used[i] = 0;
+	}
+	if (control && !stop)
+		control->done(1);
+	return seen.size();
+}
+
+void
+Pool::Search::place(unsigned int slot) {
+	if (control && !control->node()) {
+		stop = true;
+		return;
+	}
+	if (6 == slot) {
+		std::array<unsigned int, 6> set;
+		for (unsigned int i = 0; i < 6; ++i)
+			set[i] = cube[i].brick;
+		std::sort(set.begin(), set.end());
+		if (seen.insert(set).second && !visit(cube))
+			stop = true;
+		return;
+	}
+
+	// the candidates have their top side, for the lid, or their bottom
+	// side, for the others, matching the side they face
+	std::span<const Pick> candidates = 5 == slot ?
+		pool.index.fitting(0, BrickB::side(code[1], 0)) :
+		pool.index.fitting(2, Side::flip(BrickB::side(code[0], slot - 1)));
+	for (const Pick& p: candidates) {
+		if (used[p.brick] || p.brick < cube[0].brick)
+			continue;
+		std::uint16_t k = pool.brick(p.brick).brick(p.orientation).code();
+		if (!fits(slot, k))
+			continue;
+		cube[slot] = p;
+		code[slot] = k;
+		used[p.brick] = 1;
+		place(slot + 1);
+		used[p.brick] = 0;
+		if (stop)
+			return;
+	}
+}
+
+// the checks of Algorithm on codes, the side looked up excepted
+bool
+Pool::Search::fits(unsigned int slot, std::uint16_t c) const noexcept {
+	auto cell = [](std::uint16_t c, unsigned int n) {
+		return 0 != (c >> n & 1);
+	};
+	auto side = &BrickB::side;
+	const std::uint16_t f = code[0], t = code[1], r = code[2],
+		b = code[3], l = code[4];
+	switch (slot) {
+	case 1:
+		return true;
+	case 2:
+		return Side::match(side(t, 1), Side::flip(side(c, 3))) &&
+			Side::corner(cell(f, 4), cell(t, 8), cell(c, 12));
+	case 3:
+		return Side::match(side(r, 1), Side::flip(side(c, 3))) &&
+			Side::corner(cell(f, 8), cell(r, 8), cell(c, 12));
+	case 4:
+		return Side::match(side(b, 1), Side::flip(side(c, 3))) &&
+			Side::corner(cell(f, 12), cell(b, 8), cell(c, 12)) &&
+			Side::match(side(t, 3), Side::flip(side(c, 1))) &&
+			Side::corner(cell(f, 0), cell(c, 8), cell(t, 12));
+	case 5:
+	default:
+		return Side::match(side(r, 0), side(c, 1)) &&
+			Side::match(side(b, 0), side(c, 2)) &&
+			Side::match(side(l, 0), side(c, 3)) &&
+			Side::corner(cell(t, 0), cell(l, 4), cell(c, 0)) &&
+			Side::corner(cell(r, 0), cell(t, 4), cell(c, 4)) &&
+			Side::corner(cell(b, 0), cell(r, 4), cell(c, 8)) &&
+			Side::corner(cell(l, 0), cell(b, 4), cell(c, 12));
+	}
+}
+
+bool
+Pool::find(Cube& cube) const {
+	std::function<bool(const Cube&)> visit = [&cube](const Cube& c) {
+		cube = c;
+		return false;
+	};
+	return 0 != Search(*this, visit, nullptr).run();
+}
+
+unsigned long
+Pool::enumerate(const std::function<bool(const Cube&)>& visit) const {
+	return Search(*this, visit, nullptr).run();
+}
+
+unsigned long
+Pool::enumerate(const std::function<bool(const Cube&)>& visit,
+		Control& control) const {
+	return Search(*this, visit, &control).run();
+}
+
+}
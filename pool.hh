@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <functional>
+#include "brick.hh"
+#include "index.hh"
+#include "control.hh"
+
+namespace happy_cube {
+
+// the bricks on the faces of Surface::cube()
+typedef std::array<Pick, 6> Cube;
+
+// Builds cubes out of six of many bricks, e.g. of several mixed sets.
+class Pool {
+private:
+	std::vector<Brick> bricks;
+	SideIndex index;
+
+public:
+	Pool(std::vector<Brick>&&);
+
+	const Brick& brick(unsigned int) const noexcept;
+	std::size_t size() const noexcept;
+
+	// a cube of six bricks of the pool, false if there is none
+	bool find(Cube&) const;
+
+	// Calls visit once for every set of six bricks of the pool that
+	// builds a cube, with one of its assemblies, until visit returns
+	// false. Returns the number of sets visited.
+	unsigned long enumerate(const std::function<bool(const Cube&)>& visit) const;
+	// the same, stopping on the deadline or the cancellation of control,
+	// the top level branches being the bricks on the foundation
+	unsigned long enumerate(const std::function<bool(const Cube&)>& visit,
+				Control& control) const;
+
+private:
+	class Search;
+};
+
+inline const Brick&
+Pool::brick(unsigned int i) const noexcept {
+	return bricks[i];
+}
+
+inline std::size_t
+Pool::size() const noexcept {
+	return bricks.size();
+}
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "puzzle.hh"
+
+namespace happy_cube {
+
+// Necessary conditions for six bricks to build a cube, checked on their
+// codes, in any orientation, without a search: the bricks fill exactly the 8
+// corners of the cube, and the middles of their sides pair up across the 12
+// edges of the cube, each with its complement read backwards (see
+// Side::match).
+class Prefilter {
+public:
+	// whether the bricks pass the checks
+	static bool possible(const Puzzle&) noexcept;
+};
+
+// In a byte each: the corners filled and, offset by 2, the excess of the
+// sides with middles 000 over those with 111, of 010 over 101, and of 001 or
+// 100 over 011 or 110, for the two sides starting in a byte of a code. The
+// signatures of the bytes of six bricks building a cube add up to 8 corners
+// and no excess.
+inline constexpr std::array<std::uint32_t, 256> signatures = [] {
+	// by middle, the byte counting it, up or down
+	constexpr std::uint32_t up[8] = {
+		1u << 8, 1u << 24, 1u << 16, 0, 1u << 24, 0, 0, 0,
+	};
+	constexpr std::uint32_t down[8] = {
+		0, 0, 0, 1u << 24, 0, 1u << 16, 1u << 24, 1u << 8,
+	};
+	std::array<std::uint32_t, 256> r{};
+	for (unsigned int b = 0; b < 256; ++b) {
+		r[b] = (b & 1) + (b >> 4 & 1) + 0x02020200;
+		for (unsigned int n = 0; n < 2; ++n) {
+			unsigned int m = b >> (4 * n + 1) & 7;
+			r[b] += up[m] - down[m];
+		}
+	}
+	return r;
+}();
+
+inline bool
+Prefilter::possible(const Puzzle& p) noexcept {
+	std::uint32_t s = 0;
+	for (std::uint16_t c: p)
+		s += signatures[c & 0xff] + signatures[c >> 8];
+	return 0x18181808 == s;
+}
+
+}
@@ -0,0 +1,40 @@
+#include "puzzle.hh"
+#include "intern.hh"
+#include <iomanip>
+
+namespace happy_cube {
+
+std::vector<std::reference_wrapper<const Brick> >
+Puzzle::bricks() const {
+	std::vector<std::reference_wrapper<const Brick> > v;
+	v.reserve(size());
+	for (std::uint16_t c: *this)
+		v.push_back(std::cref(intern(c)));
+	return v;
+}
+
+std::ostream&
+operator<<(std::ostream& os, const Puzzle& p) {
+	std::ios_base::fmtflags f = os.flags();
+	char fill = os.fill('0');
+	os << std::hex;
+	Puzzle::const_iterator i = p.begin(), __li = p.end();
+	os << std::setw(4) << *i;
+	for (++i; __li != i; ++i)
+		os << ' ' << std::setw(4) << *i;
+	os.fill(fill);
+	os.flags(f);
+	return os;
+}
+
+std::istream&
+operator>>(std::istream& is, Puzzle& p) {
+	std::ios_base::fmtflags f = is.flags();
+	is >> std::hex;
+	for (std::uint16_t& c: p)
+		is >> c;
+	is.flags(f);
+	return is;
+}
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include "brick.hh"
+
+namespace happy_cube {
+
+// six bricks given by their perimeter codes, see BrickB::code
+class Puzzle: protected std::array<std::uint16_t, 6> {
+private:
+	typedef std::array<std::uint16_t, 6> base_type;
+
+public:
+	using base_type::base_type;
+	using base_type::operator[];
+	using base_type::begin;
+	using base_type::end;
+	using base_type::size;
+
+	Puzzle() noexcept;
+
+	// the bricks, see intern
+	std::vector<std::reference_wrapper<const Brick> > bricks() const;
+
+friend std::ostream& operator<<(std::ostream&, const Puzzle&);
+friend std::istream& operator>>(std::istream&, Puzzle&);
+};
+
+inline
+Puzzle::Puzzle() noexcept
+	: base_type{}
+{
+}
+
+extern std::ostream& operator<<(std::ostream&, const Puzzle&);
+extern std::istream& operator>>(std::istream&, Puzzle&);
+
+}
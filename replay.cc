@@ -0,0 +1,206 @@
+// Rebuilds the search trees of Algorithm from a trace written by Trace, see
+// trace.hh, and reports the sizes of the subtrees by slot, the depths of the
+// dead ends, and the most common reasons for rejecting a brick.
+//
+// replay <trace> [<rejections shown>]
+
+#include "trace.hh"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using happy_cube::Trace;
+
+namespace {
+
+const char *const slots[] = {
+	"foundation", "top", "right", "bottom", "left", "lid",
+};
+const unsigned int n = sizeof(slots) / sizeof(slots[0]);
+
+struct Subtrees {
+	unsigned long count, nodes, max;
+};
+
+class Analysis {
+private:
+	struct Node {
+		unsigned int slot;
+		// the places counted when it was placed, and its children
+		unsigned long start, children;
+		bool solution;
+	};
+
+	// by thread
+	std::map<std::uint32_t, std::vector<Node> > stacks;
+	unsigned long places;
+
+public:
+	unsigned long searches, solutions, inconsistent;
+	std::array<Subtrees, n> subtrees;
+	std::array<unsigned long, n> dead;
+	// by slot and reason
+	std::map<std::pair<unsigned int, unsigned int>, unsigned long> rejections;
+
+	Analysis();
+
+	void add(std::uint32_t thread, Trace::Event);
+	// closes the searches cut short by their visitor or by the end
+	void finish();
+
+private:
+	void pop(std::vector<Node>&);
+	void close(std::vector<Node>&);
+};
+
+Analysis::Analysis()
+	: places(0)
+	, searches(0)
+	, solutions(0)
+	, inconsistent(0)
+	, subtrees{}
+	, dead{}
+{
+}
+
+void
+Analysis::pop(std::vector<Node>& stack) {
+	const Node& x = stack.back();
+	Subtrees& s = subtrees[x.slot];
+	unsigned long size = places - x.start;
+	++s.count;
+	s.nodes += size;
+	s.max = std::max(s.max, size);
+	if (0 == x.children && !x.solution)
+		++dead[x.slot];
+	stack.pop_back();
+}
+
+void
+Analysis::close(std::vector<Node>& stack) {
+	while (!stack.empty())
+		pop(stack);
+}
+
+void
+Analysis::add(std::uint32_t thread, Trace::Event e) {
+	std::vector<Node>& stack = stacks[thread];
+	unsigned int slot = Trace::slot(e);
+	switch (Trace::kind(e)) {
+	case Trace::search:
+		close(stack);
+		++searches;
+		stack.push_back(Node{0, places++, 0, false});
+		break;
+	case Trace::place:
+		if (stack.size() != slot) {
+			++inconsistent;
+			break;
+		}
+		++stack.back().children;
+		stack.push_back(Node{slot, places++, 0, false});
+		break;
+	case Trace::reject:
+		++rejections[std::make_pair(slot, Trace::reason(e))];
+		break;
+	case Trace::undo:
+		if (stack.size() != slot + 1) {
+			++inconsistent;
+			break;
+		}
+		pop(stack);
+		break;
+	case Trace::solution:
+		++solutions;
+		if (!stack.empty())
+			stack.back().solution = true;
+		break;
+	}
+}
+
+void
+Analysis::finish() {
+	for (auto& s: stacks)
+		close(s.second);
+}
+
+std::string
+reason(unsigned int r) {
+	switch (r) {
+	case Trace::corner:
+		return "corner";
+	case Trace::symmetry:
+		return "symmetry";
+	case Trace::other:
+		return "other";
+	default:
+		return r < n ? std::string("edge with ") + slots[r] : "unknown";
+	}
+}
+
+}
+
+int
+main(int argc, char *argv[]) {
+	if (argc < 2) {
+		std::cerr << "usage: replay <trace> [<rejections shown>]" << std::endl;
+		return 1;
+	}
+	unsigned int shown = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10;
+
+	std::ifstream is(argv[1], std::ios::binary);
+	char magic[8];
+	if (!is.read(magic, sizeof(magic)) || 0 != std::string(magic, 8).compare("HCTRACE1")) {
+		std::cerr << argv[1] << ": not a trace" << std::endl;
+		return 1;
+	}
+	Analysis a;
+	unsigned long events = 0;
+	std::vector<Trace::Event> chunk;
+	for (std::uint32_t header[2]; is.read(reinterpret_cast<char *>(header), sizeof(header));) {
+		chunk.resize(header[1]);
+		if (!is.read(reinterpret_cast<char *>(chunk.data()), chunk.size() * sizeof(Trace::Event))) {
+			std::cerr << argv[1] << ": truncated" << std::endl;
+			break;
+		}
+		for (Trace::Event e: chunk)
+			a.add(header[0], e);
+		events += chunk.size();
+	}
+	a.finish();
+
+	std::cout << events << " events, " << a.searches << " searches, "
+		  << a.solutions << " solutions";
+	if (0 != a.inconsistent)
+		std::cout << ", " << a.inconsistent << " events out of place";
+	std::cout << std::endl << std::endl;
+
+	std::cout << std::setw(12) << "slot" << std::setw(12) << "nodes"
+		  << std::setw(14) << "mean subtree" << std::setw(12) << "max"
+		  << std::setw(12) << "dead ends" << std::endl;
+	for (unsigned int k = 0; k < n; ++k) {
+		const Subtrees& s = a.subtrees[k];
+		std::cout << std::setw(12) << slots[k] << std::setw(12) << s.count
+			  << std::setw(14) << (0 == s.count ? 0 : double(s.nodes) / s.count)
+			  << std::setw(12) << s.max << std::setw(12) << a.dead[k] << std::endl;
+	}
+
+	std::vector<std::pair<unsigned long, std::pair<unsigned int, unsigned int> > > r;
+	for (const auto& x: a.rejections)
+		r.emplace_back(x.second, x.first);
+	std::sort(r.begin(), r.end(), [](const auto& x, const auto& y) {
+		return x.first > y.first;
+	});
+	std::cout << std::endl << "rejections" << std::endl;
+	for (unsigned int i = 0; i < r.size() && i < shown; ++i)
+		std::cout << std::setw(12) << r[i].first << "  " << slots[r[i].second.first]
+			  << ": " << reason(r[i].second.second) << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,66 @@
+#include "stream.hh"
+#include <new>
+#include <vector>
+
+namespace happy_cube {
+
+namespace {
+
+// the frames are kept in classes of 64 bytes up to 4 KiB, larger ones are
+// not kept
+const std::size_t grain = 64, classes = 64;
+
+class Frames {
+private:
+	std::vector<void *> free[classes];
+
+public:
+	~Frames();
+
+	void *get(std::size_t c);
+	bool put(std::size_t c, void *) noexcept;
+};
+
+Frames::~Frames() {
+	for (std::vector<void *>& v: free)
+		for (void *p: v)
+			::operator delete(p);
+}
+
+void *
+Frames::get(std::size_t c) {
+	if (free[c].empty())
+		return ::operator new((c + 1) * grain);
+	void *p = free[c].back();
+	free[c].pop_back();
+	return p;
+}
+
+bool
+Frames::put(std::size_t c, void *p) noexcept {
+	try {
+		free[c].push_back(p);
+		return true;
+	} catch (...) {
+		return false;
+	}
+}
+
+thread_local Frames frames;
+
+}
+
+void *
+FrameArena::allocate(std::size_t n) {
+	std::size_t c = (n - 1) / grain;
+	return c < classes ? frames.get(c) : ::operator new(n);
+}
+
+void
+FrameArena::deallocate(void *p, std::size_t n) noexcept {
+	std::size_t c = (n - 1) / grain;
+	if (c >= classes || !frames.put(c, p))
+		::operator delete(p);
+}
+
+}
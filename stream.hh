@@ -0,0 +1,226 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <utility>
+
+namespace happy_cube {
+
+// Keeps the frames of finished coroutines, per thread and by size, for the
+// next coroutines of the same size.
+class FrameArena {
+public:
+	static void *allocate(std::size_t);
+	static void deallocate(void *, std::size_t) noexcept;
+};
+
+// A lazy sequence of values, computed by a coroutine as they are pulled.
+// The values yielded are lvalues of the coroutine, seen by reference until
+// the next one is pulled. It is a move-only input view, e.g. for
+// std::views::take or std::views::filter.
+template<typename T>
+class Stream: public std::ranges::view_base {
+public:
+	class promise_type {
+	private:
+		const T *value_;
+		std::exception_ptr exception;
+
+	friend class Stream;
+
+	public:
+		Stream get_return_object() noexcept;
+		std::suspend_always initial_suspend() const noexcept;
+		std::suspend_always final_suspend() const noexcept;
+		std::suspend_always yield_value(const T&) noexcept;
+		void return_void() const noexcept;
+		void unhandled_exception() noexcept;
+
+		static void *operator new(std::size_t);
+		static void operator delete(void *, std::size_t) noexcept;
+	};
+
+	class iterator {
+	private:
+		std::coroutine_handle<promise_type> handle;
+
+	public:
+		typedef std::input_iterator_tag iterator_concept;
+		typedef T value_type;
+		typedef std::ptrdiff_t difference_type;
+
+		iterator() noexcept;
+		explicit iterator(std::coroutine_handle<promise_type>) noexcept;
+
+		const T& operator*() const noexcept;
+		iterator& operator++();
+		void operator++(int);
+
+		bool operator==(std::default_sentinel_t) const noexcept;
+	};
+
+private:
+	std::coroutine_handle<promise_type> handle;
+
+	explicit Stream(std::coroutine_handle<promise_type>) noexcept;
+
+public:
+	Stream() noexcept;
+	Stream(Stream&&) noexcept;
+	Stream& operator=(Stream&&) noexcept;
+	~Stream();
+
+	// runs the coroutine up to its first value
+	iterator begin();
+	std::default_sentinel_t end() const noexcept;
+};
+
+template<typename T>
+inline Stream<T>
+Stream<T>::promise_type::get_return_object() noexcept {
+	return Stream(std::coroutine_handle<promise_type>::from_promise(*this));
+}
+
+template<typename T>
+inline std::suspend_always
+Stream<T>::promise_type::initial_suspend() const noexcept {
+	return {};
+}
+
+template<typename T>
+inline std::suspend_always
+Stream<T>::promise_type::final_suspend() const noexcept {
+	return {};
+}
+
+template<typename T>
+inline std::suspend_always
+Stream<T>::promise_type::yield_value(const T& v) noexcept {
+	value_ = std::addressof(v);
+	return {};
+}
+
+template<typename T>
+inline void
+Stream<T>::promise_type::return_void() const noexcept {
+}
+
+template<typename T>
+inline void
+Stream<T>::promise_type::unhandled_exception() noexcept {
+	exception = std::current_exception();
+}
+
+template<typename T>
+inline void *
+Stream<T>::promise_type::operator new(std::size_t n) {
+	return FrameArena::allocate(n);
+}
+
+template<typename T>
+inline void
+Stream<T>::promise_type::operator delete(void *p, std::size_t n) noexcept {
+	FrameArena::deallocate(p, n);
+}
+
+template<typename T>
+inline
+Stream<T>::iterator::iterator() noexcept
+	: handle(nullptr)
+{
+}
+
+template<typename T>
+inline
+Stream<T>::iterator::iterator(std::coroutine_handle<promise_type> handle__) noexcept
+	: handle(handle__)
+{
+}
+
+template<typename T>
+inline const T&
+Stream<T>::iterator::operator*() const noexcept {
+	return *handle.promise().value_;
+}
+
+template<typename T>
+inline typename Stream<T>::iterator&
+Stream<T>::iterator::operator++() {
+	handle.resume();
+	if (handle.done() && handle.promise().exception)
+		std::rethrow_exception(handle.promise().exception);
+	return *this;
+}
+
+template<typename T>
+inline void
+Stream<T>::iterator::operator++(int) {
+	++*this;
+}
+
+template<typename T>
+inline bool
+Stream<T>::iterator::operator==(std::default_sentinel_t) const noexcept {
+	return !handle || handle.done();
+}
+
+template<typename T>
+inline
+Stream<T>::Stream(std::coroutine_handle<promise_type> handle__) noexcept
+	: handle(handle__)
+{
+}
+
+template<typename T>
+inline
+Stream<T>::Stream() noexcept
+	: handle(nullptr)
+{
+}
+
+template<typename T>
+inline
+Stream<T>::Stream(Stream&& other) noexcept
+	: handle(std::exchange(other.handle, nullptr))
+{
+}
+
+template<typename T>
+inline Stream<T>&
+Stream<T>::operator=(Stream&& other) noexcept {
+	if (this != &other) {
+		if (handle)
+			handle.destroy();
+		handle = std::exchange(other.handle, nullptr);
+	}
+	return *this;
+}
+
+template<typename T>
+inline
+Stream<T>::~Stream() {
+	if (handle)
+		handle.destroy();
+}
+
+template<typename T>
+inline typename Stream<T>::iterator
+Stream<T>::begin() {
+	if (!handle)
+		return iterator();
+	iterator i(handle);
+	++i;
+	return i;
+}
+
+template<typename T>
+inline std::default_sentinel_t
+Stream<T>::end() const noexcept {
+	return std::default_sentinel;
+}
+
+}
@@ -0,0 +1,77 @@
+#include "surface.hh"
+#include <map>
+#include <set>
+
+namespace happy_cube {
+
+Surface::Surface(std::vector<Face>&& faces__)
+	: faces_(std::move(faces__))
+{
+	std::map<Point, Junction> points;
+	for (unsigned int f = 0; f < faces_.size(); ++f)
+		for (unsigned int c = 0; c < 16; ++c)
+			points[faces_[f].cell(c)].push_back(Cell{f, c});
+	for (auto& p: points)
+		if (p.second.size() > 1)
+			junctions_.push_back(std::move(p.second));
+
+	std::map<std::pair<unsigned int, unsigned int>, Edge> edges;
+	for (unsigned int j = 0; j < junctions_.size(); ++j) {
+		const Junction& junction = junctions_[j];
+		if (0 == junction.front().cell % 4)
+			corners_.push_back(j);
+		else if (2 == junction.size()) {
+			Edge& e = edges[std::make_pair(junction[0].face,
+						       junction[1].face)];
+			e.a = junction[0].face;
+			e.b = junction[1].face;
+			e.junctions.push_back(j);
+		}
+	}
+	for (auto& e: edges)
+		edges_.push_back(std::move(e.second));
+}
+
+const Surface&
+Surface::cube() {
+	static const Surface s(std::vector<Face>(cube_faces.begin(), cube_faces.end()));
+	return s;
+}
+
+Surface
+Surface::polycube(const std::vector<Point>& cubes) {
+	// in the order of the faces of cube()
+	static const Point normals[] = {
+		{0, 0, -1}, {0, 1, 0}, {-1, 0, 0}, {0, -1, 0}, {1, 0, 0}, {0, 0, 1},
+	};
+	std::set<Point> solid(cubes.begin(), cubes.end());
+
+	std::vector<Face> faces;
+	for (const Point& c: cubes)
+		for (const Point& n: normals) {
+			if (solid.end() != solid.find(Point{c[0] + n[0], c[1] + n[1], c[2] + n[2]}))
+				continue;
+			Point up = 0 == n[2] ? Point{0, 0, 1} : Point{0, 1, 0};
+			// right x up = n
+			Point right{up[1] * n[2] - up[2] * n[1],
+				    up[2] * n[0] - up[0] * n[2],
+				    up[0] * n[1] - up[1] * n[0]};
+			Point origin;
+			for (unsigned int i = 0; i < 3; ++i)
+				origin[i] = 4 * c[i] + 2 + 2 * n[i] - 2 * right[i] - 2 * up[i];
+			faces.push_back(Face{origin, right, up});
+		}
+	return Surface(std::move(faces));
+}
+
+Surface
+Surface::cuboid(unsigned int a, unsigned int b, unsigned int c) {
+	std::vector<Point> cubes;
+	for (unsigned int z = 0; z < c; ++z)
+		for (unsigned int y = 0; y < b; ++y)
+			for (unsigned int x = 0; x < a; ++x)
+				cubes.push_back(Point{int(x), int(y), int(z)});
+	return polycube(cubes);
+}
+
+}
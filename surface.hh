@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+namespace happy_cube {
+
+typedef std::array<int, 3> Point;
+
+// A face of a polycube surface, given by the position of its bottom left
+// cell and by the unit vectors along its rows and columns, as seen from
+// outside the solid. A brick laid on the face covers the 5x5 cells
+// origin + col * right + row * up, 0 <= col, row <= 4.
+struct Face {
+	Point origin;
+	Point right;
+	Point up;
+
+	// the position of a perimeter cell in the numbering of BrickB
+	constexpr Point cell(unsigned int) const noexcept;
+};
+
+// a perimeter cell of a face
+struct Cell {
+	unsigned int face;
+	unsigned int cell;
+};
+
+// The perimeter cells of several faces that fall on the same point. In
+// an assembly exactly one of them is filled.
+typedef std::vector<Cell> Junction;
+
+// two faces meeting along a side, given by the junctions of the middle
+// cells of that side
+struct Edge {
+	unsigned int a, b;
+	std::vector<unsigned int> junctions;
+};
+
+class Surface {
+private:
+	std::vector<Face> faces_;
+	std::vector<Junction> junctions_;
+	std::vector<Edge> edges_;
+	// the junctions of corner cells
+	std::vector<unsigned int> corners_;
+
+public:
+	Surface(std::vector<Face>&&);
+
+	const std::vector<Face>& faces() const noexcept;
+	const std::vector<Junction>& junctions() const noexcept;
+	const std::vector<Edge>& edges() const noexcept;
+	const std::vector<unsigned int>& corners() const noexcept;
+
+	// The cube in the frames used by Solution::assemble: the foundation,
+	// the top, right, bottom, and left bricks, each with its bottom side
+	// on the foundation, and the lid seen from inside the cube.
+	static const Surface& cube();
+
+	// The surface of a solid made of unit cubes, cube (x, y, z)
+	// spanning the cells 4x..4x+4, 4y..4y+4, 4z..4z+4. The faces are
+	// seen from outside, with up along z if they are vertical and along
+	// y otherwise.
+	static Surface polycube(const std::vector<Point>&);
+	static Surface cuboid(unsigned int, unsigned int, unsigned int);
+};
+
+// the faces of Surface::cube()
+inline constexpr std::array<Face, 6> cube_faces{{
+	// foundation
+	{{4, 0, 0}, {-1, 0, 0}, {0, 1, 0}},
+	// top
+	{{4, 4, 0}, {-1, 0, 0}, {0, 0, 1}},
+	// right
+	{{0, 4, 0}, {0, -1, 0}, {0, 0, 1}},
+	// bottom
+	{{0, 0, 0}, {1, 0, 0}, {0, 0, 1}},
+	// left
+	{{4, 0, 0}, {0, 1, 0}, {0, 0, 1}},
+	// lid
+	{{4, 0, 4}, {-1, 0, 0}, {0, 1, 0}},
+}};
+
+constexpr Point
+Face::cell(unsigned int c) const noexcept {
+	int col, row;
+	if (c < 4) {
+		// top side, left to right
+		col = c;
+		row = 4;
+	} else if (c < 8) {
+		// right side, top to bottom
+		col = 4;
+		row = 8 - c;
+	} else if (c < 12) {
+		// bottom side, right to left
+		col = 12 - c;
+		row = 0;
+	} else {
+		// left side, bottom to top
+		col = 0;
+		row = c - 12;
+	}
+	return Point{origin[0] + col * right[0] + row * up[0],
+		     origin[1] + col * right[1] + row * up[1],
+		     origin[2] + col * right[2] + row * up[2]};
+}
+
+inline const std::vector<Face>&
+Surface::faces() const noexcept {
+	return faces_;
+}
+
+inline const std::vector<Junction>&
+Surface::junctions() const noexcept {
+	return junctions_;
+}
+
+inline const std::vector<Edge>&
+Surface::edges() const noexcept {
+	return edges_;
+}
+
+inline const std::vector<unsigned int>&
+Surface::corners() const noexcept {
+	return corners_;
+}
+
+}
@@ -0,0 +1,92 @@
+#include "symmetry.hh"
+#include "brick.hh"
+#include <algorithm>
+#include <limits>
+
+namespace happy_cube {
+
+static Point
+center(const Face& f) noexcept {
+	return Point{f.origin[0] + 2 * f.right[0] + 2 * f.up[0],
+		     f.origin[1] + 2 * f.right[1] + 2 * f.up[1],
+		     f.origin[2] + 2 * f.right[2] + 2 * f.up[2]};
+}
+
+std::vector<Symmetry>
+symmetries(const Surface& surface) {
+	const std::vector<Face>& faces = surface.faces();
+
+	// work with doubled coordinates such that the center of the
+	// bounding box is a lattice point
+	Point lo, hi;
+	lo.fill(std::numeric_limits<int>::max());
+	hi.fill(std::numeric_limits<int>::min());
+	for (const Face& f: faces)
+		for (unsigned int c = 0; c < 16; c += 4) {
+			Point p = f.cell(c);
+			for (unsigned int i = 0; i < 3; ++i) {
+				lo[i] = std::min(lo[i], p[i]);
+				hi[i] = std::max(hi[i], p[i]);
+			}
+		}
+
+	std::vector<Symmetry> r;
+	// the 48 signed permutations of the axes
+	unsigned int axes[3] = {0, 1, 2};
+	do {
+		for (unsigned int signs = 0; signs < 8; ++signs) {
+			auto g = [&](const Point& p) {
+				Point q;
+				for (unsigned int i = 0; i < 3; ++i) {
+					int x = 2 * p[axes[i]] - lo[axes[i]] - hi[axes[i]];
+					q[i] = ((signs >> i & 1) ? -x : x) + lo[i] + hi[i];
+				}
+				return q;
+			};
+			auto doubled = [](const Point& p) {
+				return Point{2 * p[0], 2 * p[1], 2 * p[2]};
+			};
+
+			Symmetry s;
+			bool identity = true;
+			for (unsigned int f = 0; f < faces.size(); ++f) {
+				Point p = g(center(faces[f]));
+				auto k = std::find_if(faces.begin(), faces.end(),
+						      [&p, &doubled](const Face& e) {
+							      return doubled(center(e)) == p;
+						      });
+				if (faces.end() == k)
+					break;
+				unsigned int to = k - faces.begin();
+				unsigned int n = 0;
+				for (; n < 8; ++n) {
+					unsigned int c = 0;
+					for (; c < 16; ++c) {
+						std::uint16_t d = BrickB::transform(1 << c, n);
+						unsigned int e = __builtin_ctz(d);
+						if (g(faces[f].cell(c)) != doubled(k->cell(e)))
+							break;
+					}
+					if (16 == c)
+						break;
+				}
+				if (8 == n)
+					break;
+				identity = identity && to == f && 0 == n;
+				s.face.push_back(to);
+				s.turn.push_back(n);
+			}
+			if (s.face.size() != faces.size() || identity)
+				continue;
+
+			s.from.resize(faces.size());
+			for (unsigned int f = 0; f < faces.size(); ++f)
+				s.from[s.face[f]] = f;
+			r.push_back(std::move(s));
+		}
+	} while (std::next_permutation(axes, axes + 3));
+
+	return r;
+}
+
+}
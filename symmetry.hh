@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+#include "surface.hh"
+
+namespace happy_cube {
+
+// A rotation or reflection mapping a surface onto itself. The brick on face
+// f moves to face face[f] where its code is BrickB::transform(code,
+// turn[f]) in the frame of that face.
+struct Symmetry {
+	std::vector<unsigned int> face;
+	std::vector<unsigned int> turn;
+	// the face whose brick moves to face f
+	std::vector<unsigned int> from;
+};
+
+// the symmetries of a surface other than the identity
+extern std::vector<Symmetry> symmetries(const Surface&);
+
+}
@@ -0,0 +1,91 @@
+#include "trace.hh"
+#include <chrono>
+#include <algorithm>
+
+namespace happy_cube {
+
+// the trace being written, and a count of the traces, so that a thread
+// notices that the ring it keeps belongs to a trace that ended
+static std::atomic<Trace *> current(nullptr);
+static std::atomic<unsigned int> generation(0);
+
+Trace::Ring::Ring(unsigned int thread__) noexcept
+	: head(0)
+	, tail(0)
+	, thread(thread__)
+{
+}
+
+Trace::Trace(const std::string& path)
+	: file(std::fopen(path.c_str(), "wb"))
+	, stop(false)
+{
+	if (!file)
+		return;
+	std::fwrite("HCTRACE1", 1, 8, file);
+	current.store(this);
+	++generation;
+	writer = std::thread([this]() {
+		while (!stop.load()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			drain();
+		}
+	});
+}
+
+Trace::~Trace() {
+	if (!file)
+		return;
+	current.store(nullptr);
+	++generation;
+	stop.store(true);
+	writer.join();
+	drain();
+	std::fclose(file);
+}
+
+bool
+Trace::good() const noexcept {
+	return nullptr != file;
+}
+
+Trace::Ring *
+Trace::ring() {
+	static thread_local Ring *r = nullptr;
+	static thread_local unsigned int seen = 0;
+	unsigned int g = generation.load(std::memory_order_relaxed);
+	if (seen != g) {
+		Trace *t = current.load();
+		r = t ? &t->add() : nullptr;
+		seen = g;
+	}
+	return r;
+}
+
+Trace::Ring&
+Trace::add() {
+	std::lock_guard<std::mutex> lock(mutex);
+	rings.push_back(std::make_unique<Ring>(rings.size()));
+	return *rings.back();
+}
+
+// writes the events of every ring in at most two chunks, where the ring
+// wraps around
+void
+Trace::drain() {
+	std::lock_guard<std::mutex> lock(mutex);
+	for (const std::unique_ptr<Ring>& r: rings) {
+		std::size_t t = r->tail.load(std::memory_order_relaxed),
+			h = r->head.load(std::memory_order_acquire);
+		while (t != h) {
+			std::uint32_t n = std::min(h - t, Ring::size - t % Ring::size);
+			std::uint32_t header[2] = {r->thread, n};
+			std::fwrite(header, sizeof(header), 1, file);
+			std::fwrite(&r->events[t % Ring::size], sizeof(Event), n, file);
+			t += n;
+		}
+		r->tail.store(t, std::memory_order_release);
+	}
+}
+
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace happy_cube {
+
+// A binary trace of the search events of Algorithm, two bytes each, kept by
+// every thread in its own ring and written to a file by a thread of the
+// trace. The file is "HCTRACE1" and chunks of events of one thread each: its
+// number and the number of events, 4 bytes each, and the events, all in the
+// byte order of the host. The events of a thread are in order.
+class Trace {
+public:
+	enum Kind {
+		// a search starting with the brick on the foundation
+		search,
+		place,
+		reject,
+		// the brick on a slot taken off
+		undo,
+		// the brick on the last slot completing an assembly
+		solution,
+	};
+
+	// why a brick does not fit a slot: an edge with the brick on an
+	// earlier slot, numbered as the slot, a corner, or the symmetries
+	enum Reason {
+		corner = 6,
+		symmetry,
+		other,
+	};
+
+	// bits 0-2 the kind, 3-5 the slot, 6-8 the brick, 9-11 its
+	// orientation, 12-15 the reason
+	typedef std::uint16_t Event;
+
+	static constexpr Event event(Kind, unsigned int slot, unsigned int brick = 0,
+				     unsigned int orientation = 0, unsigned int reason = 0) noexcept;
+	static constexpr Kind kind(Event) noexcept;
+	static constexpr unsigned int slot(Event) noexcept;
+	static constexpr unsigned int brick(Event) noexcept;
+	static constexpr unsigned int orientation(Event) noexcept;
+	static constexpr unsigned int reason(Event) noexcept;
+
+	// The events of one thread, written by it and read by the trace.
+	// When full, the thread waits for the trace to catch up.
+	class Ring {
+	private:
+		static constexpr std::size_t size = 1 << 16;
+
+		std::array<Event, size> events;
+		std::atomic<std::size_t> head, tail;
+		const unsigned int thread;
+
+	friend class Trace;
+
+	public:
+		explicit Ring(unsigned int thread) noexcept;
+
+		void push(Event) noexcept;
+	};
+
+private:
+	std::FILE *file;
+	std::mutex mutex;
+	std::vector<std::unique_ptr<Ring> > rings;
+	std::atomic<bool> stop;
+	std::thread writer;
+
+public:
+	// traces the searches of all the threads into a file until destroyed;
+	// one trace at a time
+	explicit Trace(const std::string& path);
+	Trace(const Trace&) = delete;
+	~Trace();
+
+	bool good() const noexcept;
+
+	// the ring of the calling thread, nullptr if nothing is traced
+	static Ring *ring();
+
+private:
+	Ring& add();
+	void drain();
+};
+
+constexpr Trace::Event
+Trace::event(Kind k, unsigned int slot, unsigned int brick, unsigned int orientation,
+	     unsigned int reason) noexcept {
+	return k | slot << 3 | brick << 6 | orientation << 9 | reason << 12;
+}
+
+constexpr Trace::Kind
+Trace::kind(Event e) noexcept {
+	return static_cast<Kind>(e & 7);
+}
+
+constexpr unsigned int
+Trace::slot(Event e) noexcept {
+	return e >> 3 & 7;
+}
+
+constexpr unsigned int
+Trace::brick(Event e) noexcept {
+	return e >> 6 & 7;
+}
+
+constexpr unsigned int
+Trace::orientation(Event e) noexcept {
+	return e >> 9 & 7;
+}
+
+constexpr unsigned int
+Trace::reason(Event e) noexcept {
+	return e >> 12;
+}
+
+inline void
+Trace::Ring::push(Event e) noexcept {
+	std::size_t h = head.load(std::memory_order_relaxed);
+	while (h - tail.load(std::memory_order_acquire) == size)
+		std::this_thread::yield();
+	events[h % size] = e;
+	head.store(h + 1, std::memory_order_release);
+}
+
+}
@@ -0,0 +1,49 @@
+#include "transpositions.hh"
+#include <algorithm>
+
+namespace happy_cube {
+
+// the data of an entry: the count above the depth, 0 for an empty entry as
+// the depth of a partial assembly is at least 1
+static const unsigned int depth_bits = 8;
+
+Transpositions::Transpositions(unsigned int bits, Policy policy__)
+	: entries(new Entry[std::size_t(1) << bits])
+	, mask((std::uint64_t(1) << bits) - 1)
+	, policy(policy__)
+{
+	clear();
+}
+
+bool
+Transpositions::find(std::uint64_t key, std::uint64_t& count) const noexcept {
+	const Entry& e = entries[key & mask];
+	std::uint64_t data = e.data.load(std::memory_order_relaxed);
+	if (0 == data || (e.check.load(std::memory_order_relaxed) ^ data) != key)
+		return false;
+	count = data >> depth_bits;
+	return true;
+}
+
+void
+Transpositions::store(std::uint64_t key, std::uint64_t count, unsigned int depth) noexcept {
+	Entry& e = entries[key & mask];
+	std::uint64_t old = e.data.load(std::memory_order_relaxed);
+	if (shallow == policy && 0 != old &&
+	    (old & ((1u << depth_bits) - 1)) < depth)
+		return;
+	std::uint64_t data = std::min<std::uint64_t>(count, ~std::uint64_t(0) >> depth_bits)
+		<< depth_bits | std::min(depth, (1u << depth_bits) - 1);
+	e.check.store(key ^ data, std::memory_order_relaxed);
+	e.data.store(data, std::memory_order_relaxed);
+}
+
+void
+Transpositions::clear() noexcept {
+	for (std::uint64_t i = 0; i <= mask; ++i) {
+		entries[i].check.store(0, std::memory_order_relaxed);
+		entries[i].data.store(0, std::memory_order_relaxed);
+	}
+}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+namespace happy_cube {
+
+// A bounded table of the number of assemblies completing partial assemblies,
+// by a 64-bit key, shared by the searches of several threads without locks.
+// An entry is two words, the data and the key xor-ed with the data, written
+// and read with relaxed atomics, such that an entry torn by concurrent
+// stores fails the check of its key and is taken for absent.
+class Transpositions {
+public:
+	enum Policy {
+		// a store replaces the entry in its place
+		always,
+		// a store replaces the entry in its place unless that one has
+		// fewer slots placed, i.e. stands for a larger subtree
+		shallow,
+	};
+
+private:
+	struct Entry {
+		std::atomic<std::uint64_t> check, data;
+	};
+
+	std::unique_ptr<Entry[]> entries;
+	std::uint64_t mask;
+	Policy policy;
+
+public:
+	// 2^bits entries
+	Transpositions(unsigned int bits, Policy = shallow);
+
+	// the number of assemblies stored for key, false if there is none
+	bool find(std::uint64_t key, std::uint64_t& count) const noexcept;
+	// the number of assemblies completing a partial assembly of depth
+	// slots, 0 for none
+	void store(std::uint64_t key, std::uint64_t count, unsigned int depth) noexcept;
+	void clear() noexcept;
+};
+
+}
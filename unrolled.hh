@@ -0,0 +1,231 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <cstdint>
+#include "brick.hh"
+#include "surface.hh"
+#include "piece.hh"
+#include "control.hh"
+
+namespace happy_cube {
+
+// A junction closed by the brick on a slot: its cell on that brick and the
+// cells on the bricks of earlier slots.
+struct Closure {
+	struct Other {
+		unsigned char slot, cell;
+	};
+
+	unsigned char cell;
+	unsigned char count;
+	std::array<Other, 3> others;
+};
+
+// The slots of a surface of n faces in the order of placing and the
+// junctions each of them closes, computed at compile time.
+template<std::size_t n>
+struct Layout {
+	std::array<unsigned char, n> face;
+	std::array<unsigned char, n> count;
+	std::array<std::array<Closure, 16>, n> closures;
+};
+
+// The layout of the faces placed in the order given. The cells of faces
+// that fall on the same point form a junction, closed by the last of its
+// faces placed.
+template<std::size_t n>
+constexpr Layout<n>
+compile(const std::array<Face, n>& faces, const std::array<unsigned char, n>& order) {
+	Layout<n> l{};
+	for (unsigned int k = 0; k < n; ++k) {
+		l.face[k] = order[k];
+		for (unsigned int c = 0; c < 16; ++c) {
+			Point p = faces[order[k]].cell(c);
+			Closure x{static_cast<unsigned char>(c), 0, {}};
+			unsigned int total = 0;
+			for (unsigned int j = 0; j < n; ++j)
+				for (unsigned int e = 0; j != k && e < 16; ++e) {
+					if (faces[order[j]].cell(e) != p)
+						continue;
+					++total;
+					if (j < k)
+						x.others[x.count++] = Closure::Other{
+							static_cast<unsigned char>(j),
+							static_cast<unsigned char>(e)};
+				}
+			if (0 != total && total == x.count)
+				l.closures[k][l.count[k]++] = x;
+		}
+	}
+	return l;
+}
+
+// the cube placed in the order of Algorithm: foundation, top, right,
+// bottom, left, and lid
+inline constexpr Layout<6> cube_layout = compile(cube_faces, {0, 1, 2, 3, 4, 5});
+
+// A backtracker instantiated from a layout, one function per slot, each
+// testing the junctions of its slot by fully unrolled code. The bricks are
+// in the order of Brick, the first one is placed on the first slot in its
+// first orientation, and equal bricks are placed in the order of their
+// indices. The top level branches of a control are the bricks on the
+// second slot.
+template<const auto& layout>
+class Unrolled {
+private:
+	static constexpr std::size_t n = layout.face.size();
+
+	const PieceTable& table;
+	const std::function<bool(const std::array<Pick, n>&)>& visit;
+	Control *control;
+	// whether each brick equals the one before it
+	std::vector<char> same;
+	// the bricks searched on the second slot
+	unsigned int first, last;
+
+	std::array<unsigned int, n> picks;
+	std::array<std::uint16_t, n> code;
+	std::vector<char> used;
+	unsigned long count;
+	bool stop;
+
+public:
+	Unrolled(const std::vector<std::reference_wrapper<const Brick> >&,
+		 const PieceTable&,
+		 const std::function<bool(const std::array<Pick, n>&)>&,
+		 Control * = nullptr);
+
+	// calls visit, by face, for every assembly until it returns false;
+	// returns the number of assemblies visited
+	unsigned long run();
+	// the same, searching only the top level branch of brick b + 1 on the
+	// second slot
+	unsigned long run(unsigned int b);
+
+private:
+	template<std::size_t k>
+	void place();
+
+	template<std::size_t k, std::size_t i>
+	bool close(unsigned int& value) const noexcept;
+
+	template<std::size_t k>
+	static constexpr unsigned int mask() noexcept;
+};
+
+template<const auto& layout>
+inline
+Unrolled<layout>::Unrolled(const std::vector<std::reference_wrapper<const Brick> >& bricks,
+			   const PieceTable& table__,
+			   const std::function<bool(const std::array<Pick, n>&)>& visit__,
+			   Control *control__)
+	: table(table__)
+	, visit(visit__)
+	, control(control__)
+	, first(1)
+	, last(bricks.size())
+	, used(bricks.size(), 0)
+	, count(0)
+	, stop(false)
+{
+	assert(n == bricks.size());
+	same.push_back(0);
+	for (unsigned int b = 1; b < bricks.size(); ++b)
+		same.push_back(bricks[b].get() == bricks[b - 1].get());
+}
+
+template<const auto& layout>
+inline unsigned long
+Unrolled<layout>::run() {
+	picks[0] = table.id(0, 0);
+	code[0] = table.code(picks[0]);
+	used[0] = 1;
+	place<1>();
+	if (control && !stop)
+		control->done(1);
+	return count;
+}
+
+template<const auto& layout>
+inline unsigned long
+Unrolled<layout>::run(unsigned int b) {
+	first = b + 1;
+	last = b + 2;
+	return run();
+}
+
+template<const auto& layout>
+template<std::size_t k>
+constexpr unsigned int
+Unrolled<layout>::mask() noexcept {
+	unsigned int r = 0;
+	for (unsigned int i = 0; i < layout.count[k]; ++i)
+		r |= 1u << layout.closures[k][i].cell;
+	return r;
+}
+
+// adds the cell of closure i of slot k to the cells that have to be filled
+// if none of the others is, false if more than one of them is
+template<const auto& layout>
+template<std::size_t k, std::size_t i>
+inline bool
+Unrolled<layout>::close(unsigned int& value) const noexcept {
+	constexpr const Closure& x = layout.closures[k][i];
+	unsigned int filled = [this]<std::size_t... j>(std::index_sequence<j...>) {
+		return (0u + ... + (code[x.others[j].slot] >> x.others[j].cell & 1));
+	}(std::make_index_sequence<layout.closures[k][i].count>());
+	value |= (0 == filled) << layout.closures[k][i].cell;
+	return filled < 2;
+}
+
+template<const auto& layout>
+template<std::size_t k>
+inline void
+Unrolled<layout>::place() {
+	if (control && !control->node()) {
+		stop = true;
+		return;
+	}
+	if constexpr (n == k) {
+		std::array<Pick, n> a;
+		for (unsigned int s = 0; s < n; ++s)
+			a[layout.face[s]] = Pick{table.brick(picks[s]),
+						 table.orientation(picks[s])};
+		++count;
+		stop = !visit(a);
+	} else {
+		constexpr unsigned int m = mask<k>();
+		unsigned int value = 0;
+		bool closes = [this, &value]<std::size_t... i>(std::index_sequence<i...>) {
+			return (... && close<k, i>(value));
+		}(std::make_index_sequence<layout.count[k]>());
+		if (!closes)
+			return;
+
+		for (unsigned int b = 1 == k ? first : 1; b < (1 == k ? last : used.size()); ++b) {
+			// equal bricks are placed in the order of their indices
+			if (1 == k && control)
+				control->done(double(b - 1) / (n - 1));
+			if (used[b] || (same[b] && !used[b - 1]))
+				continue;
+			unsigned int id = table.id(b, 0), last = id + table.degree(b);
+			for (; id < last; ++id) {
+				std::uint16_t c = table.code(id);
+				if ((c & m) != value)
+					continue;
+				picks[k] = id;
+				code[k] = c;
+				used[b] = 1;
+				place<k + 1>();
+				used[b] = 0;
+				if (stop)
+					return;
+			}
+		}
+	}
+}
+
+}